@@ -20,6 +20,7 @@
 #include <netp/packet.hpp>
 #include <netp/bytes_ringbuffer.hpp>
 #include <netp/heap.hpp>
+#include <netp/histogram.hpp>
 
 #include <netp/helper.hpp>
 
@@ -41,12 +42,14 @@
 #include <netp/logger/net_logger.hpp>
 
 #include <netp/scheduler.hpp>
+#include <netp/executor.hpp>
 
 #include <netp/security/dh.hpp>
 #include <netp/security/xxtea.hpp>
 
 #include <netp/address.hpp>
 #include <netp/socket.hpp>
+#include <netp/tcp_info_sampler.hpp>
 #include <netp/icmp.hpp>
 
 #include <netp/util_hlen.hpp>
@@ -24,6 +24,15 @@
 #define NETP_SOCK_USERPACKET		(SOCK_SEQPACKET+100)
 #define NETP_SOCK_UNKNOWN		(NETP_SOCK_USERPACKET+1)
 
+//unix domain socket, the abstract namespace (sun_path[0]=='\0') is linux only
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID) || defined(_NETP_APPLE)
+	#include <sys/un.h>
+	#define NETP_ENABLE_AF_UNIX
+	#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID)
+		#define NETP_ENABLE_AF_UNIX_ABSTRACT
+	#endif
+#endif
+
 #define NETP_PROTOCOL_TCP				0
 #define NETP_PROTOCOL_UDP				1
 #define NETP_PROTOCOL_ICMP			2
@@ -63,14 +72,28 @@ namespace netp {
 	struct address final :
 		public netp::ref_base
 	{
-		sockaddr_in m_in;
+		//@note: sun_family shares its offset with sin_family, family() works for both
+		union {
+			sockaddr_in m_in;
+#ifdef NETP_ENABLE_AF_UNIX
+			struct sockaddr_un m_un;
+#endif
+		};
 		sockaddr_in6 m_in6;
+#ifdef NETP_ENABLE_AF_UNIX
+		//the length of m_un, an abstract name is not null terminated
+		socklen_t m_un_len;
+#endif
 
 		address();
 		address(const char* ip, unsigned short port, int f );
 		address(const struct sockaddr_in* sockaddr_in_, size_t slen);
 		address(const struct sockaddr_in6* sockaddr_in6_, size_t slen);
 		address(ipv4_t ip, port_t port, int f);
+#ifdef NETP_ENABLE_AF_UNIX
+		//a path, or an abstract name if path starts with '@'
+		address(const char* path, size_t len);
+#endif
 		~address();
 
 		inline bool is_loopback() {
@@ -99,9 +122,65 @@ namespace netp {
 			return (struct sockaddr*)(&m_in6);
 		}
 
+		//the sockaddr of family(), for the socket api that does not care about the family
+		struct sockaddr* sockaddr_raw() {
+			return (struct sockaddr*)(&m_in);
+		}
+		struct sockaddr const* sockaddr_raw() const {
+			return (struct sockaddr const*)(&m_in);
+		}
+
+		socklen_t sockaddr_len() const {
+#ifdef NETP_ENABLE_AF_UNIX
+			if (m_in.sin_family == NETP_AF_UNIX) {
+				return m_un_len;
+			}
+#endif
+			return sizeof(sockaddr_in);
+		}
+
+		//the room of sockaddr_raw() for accept|recvfrom|getsockname
+		static socklen_t sockaddr_capacity() {
+#ifdef NETP_ENABLE_AF_UNIX
+			return sizeof(struct sockaddr_un);
+#else
+			return sizeof(sockaddr_in);
+#endif
+		}
+
+		//call it once the kernel filled sockaddr_raw() with len bytes
+		inline void sockaddr_loaded(socklen_t len) {
+#ifdef NETP_ENABLE_AF_UNIX
+			m_un_len = len;
+#else
+			(void)len;
+#endif
+		}
+
+		inline bool is_unix() const {
+			return m_in.sin_family == NETP_AF_UNIX;
+		}
+
+#ifdef NETP_ENABLE_AF_UNIX
+		//an unnamed unix socket (an unbound client) has no path
+		inline bool is_unix_unnamed() const {
+			return is_unix() && m_un_len <= offsetof(struct sockaddr_un, sun_path);
+		}
+		inline bool is_unix_abstract() const {
+			return is_unix() && !is_unix_unnamed() && m_un.sun_path[0] == '\0';
+		}
+		//the path, or the abstract name without its leading '\0'
+		string_t unix_path() const;
+#endif
+
 		NRP<address> clone() const {
 			NRP<address> a = netp::make_ref<address>();
+#ifdef NETP_ENABLE_AF_UNIX
+			std::memcpy(&(a->m_un), &m_un, sizeof(struct sockaddr_un));
+			a->m_un_len = m_un_len;
+#else
 			std::memcpy(&(a->m_in), &m_in, sizeof(sockaddr_in));
+#endif
 			std::memcpy(&(a->m_in6), &m_in6, sizeof(sockaddr_in6));
 			return a;
 		}
@@ -117,10 +196,20 @@ namespace netp {
 		inline u64_t hash() const {
 			//@TODO ipv6 todo
 			NETP_ASSERT( m_in.sin_family != AF_INET6);
+#ifdef NETP_ENABLE_AF_UNIX
+			if (m_in.sin_family == NETP_AF_UNIX) {
+				return __unix_hash();
+			}
+#endif
 			return (u64_t(m_in.sin_addr.s_addr) << 24 | u64_t(m_in.sin_port) << 8 | u64_t(m_in.sin_family));
 		}
 
 		inline bool operator == (address const& addr) const {
+#ifdef NETP_ENABLE_AF_UNIX
+			if (m_in.sin_family == NETP_AF_UNIX || addr.m_in.sin_family == NETP_AF_UNIX) {
+				return m_in.sin_family == addr.m_in.sin_family && is_unix_abstract() == addr.is_unix_abstract() && unix_path() == addr.unix_path();
+			}
+#endif
 			return hash() == addr.hash();
 		}
 
@@ -170,6 +259,10 @@ namespace netp {
 			m_in.sin_family = u8_t(f);
 		}
 		string_t to_string() const;
+#ifdef NETP_ENABLE_AF_UNIX
+	private:
+		u64_t __unix_hash() const;
+#endif
 	};
 
 	struct address_hash {
@@ -182,7 +275,7 @@ namespace netp {
 	struct address_equal {
 		__NETP_FORCE_INLINE bool operator()(NRP<address> const& lhs, NRP<address> const& rhs) const
 		{
-			return lhs->hash() == rhs->hash();
+			return (*lhs) == (*rhs);
 		}
 	};
 }
@@ -45,8 +45,11 @@ namespace netp {
 		netp::condition m_cond;
 
 		u32_t m_loop_count;
+		u8_t m_poller_type; //io_poller_type of the default loop group
 		u32_t m_channel_read_buf_size; //in bytes
 		u32_t m_channel_tx_limit_clock; //in millis
+		u32_t m_loop_spin_us; //spin budget of the default loop group, 0 means off
+		u8_t m_loop_select_policy; //event_loop_select_policy of the default loop group
 		bool m_is_cfg_json_loaded;
 		bool m_should_exit;
 
@@ -92,7 +95,13 @@ namespace netp {
 		~app();
 
 		void cfg_loop_count(u32_t c);
+		//default|io_uring, the default one is used if it's not supported
+		void cfg_poller(std::string const& poller);
 		void cfg_channel_read_buf(u32_t buf_in_kbytes);
+		//latency mode, refer to event_loop_cfg::spin_us
+		void cfg_loop_spin_us(u32_t spin_us);
+		//round_robin|least_io_ctx|least_busy|power_of_two, refer to event_loop_select_policy
+		void cfg_loop_select(std::string const& policy);
 
 		__NETP_FORCE_INLINE
 		u32_t channel_tx_limit_clock() const { return m_channel_tx_limit_clock; }
@@ -86,7 +86,10 @@ namespace netp {
 		F_TIMER_2 = 1 << 25,
 
 		F_USE_DEFAULT_READ=1<<26,
-		F_USE_DEFAULT_WRITE = 1<<27
+		F_USE_DEFAULT_WRITE = 1<<27,
+		F_READ_REQUEUED = 1<<28, //read budget used up, the left read is scheduled to the loop
+		F_WRITE_HOLD = 1<<29, //writes are queued only, till a flush
+		F_UNWRITABLE = 1<<30 //outbound buffer above the high watermark, till it drains to the low one
 	};
 
 	struct channel_buf_cfg {
@@ -162,6 +165,7 @@ namespace netp {
 			CH_FIRE_ACTION_IMPL_0(connected)
 			CH_FIRE_ACTION_IMPL_0(read_closed)
 			CH_FIRE_ACTION_IMPL_0(write_closed)
+			CH_FIRE_ACTION_IMPL_0(writability_changed)
 
 			inline void ch_fire_closed(int code) const {
 				NETP_ASSERT(L->in_event_loop());
@@ -241,6 +245,8 @@ namespace netp {
 			m_chflag |= int(channel_flag::F_CONNECTED);
 		}
 		inline bool ch_is_connected() { return m_chflag & int(channel_flag::F_CONNECTED); }
+		//false once the outbound buffer goes above the high watermark, a producer should hold on till writability_changed
+		inline bool ch_is_writable() const { return (m_chflag & int(channel_flag::F_UNWRITABLE)) == 0; }
 		
 #define CH_FUTURE_ACTION_IMPL_CH_PROMISE_1(NAME) \
 private: \
@@ -313,7 +319,34 @@ public: \
 
 	CH_FUTURE_ACTION_IMPL_PACKET_ADDR(write_to);
 
-	/*
+private:
+		inline void __ch_write_file(NRP<promise<int>> const& intp, int fd, u64_t offset, u64_t len) {
+			if (m_pipeline == nullptr) {
+				intp->set(netp::E_CHANNEL_CLOSED);
+				return;
+			}
+			//the raw bytes of the file must not be mixed into the stream of a handler that transforms the writes
+			if (m_pipeline->has_outbound_write()) {
+				intp->set(netp::E_EOPNOTSUPP);
+				return;
+			}
+			ch_write_file_impl(intp, fd, offset, len);
+		}
+public:
+		//@note: the bytes of the file go to the transport directly, E_EOPNOTSUPP if a handler of the pipeline takes write (tls, websocket, codec), ch_write the bytes instead
+		//it keeps the order with the writes that have reached the transport, fd must be kept open until intp is set
+		//the bytes are counted to the write watermarks till they are sent
+		inline NRP<promise<int>> ch_write_file(int fd, u64_t offset, u64_t len) {
+			const NRP<promise<int>> intp = netp::make_ref<promise<int>>();
+			ch_write_file(intp, fd, offset, len);
+			return intp;
+		}
+		inline void ch_write_file(NRP<promise<int>> const& intp, int fd, u64_t offset, u64_t len) {
+			L->execute([_ch = NRP<channel>(this), intp, fd, offset, len]() {
+				_ch->__ch_write_file(intp, fd, offset, len);
+			});
+		}
+
 #define CH_ACTION_IMPL_VOID(NAME) \
 private: \
 		inline void __ch_##NAME() { \
@@ -328,7 +361,9 @@ public: \
 				_ch->__ch_##NAME(); \
 			}); \
 		} \
-		*/
+
+	//push out the writes held by the transport
+	CH_ACTION_IMPL_VOID(flush)
 
 		void io_notify_terminating(int, io_ctx*) {};
 		void io_notify_read(int, io_ctx*) {};
@@ -353,6 +388,14 @@ public: \
 			(void)intp;
 		};
 
+		virtual void ch_flush_impl() {}
+		virtual void ch_write_file_impl(NRP<promise<int>> const& intp, int fd, u64_t offset, u64_t len) {
+			(void)fd;
+			(void)offset;
+			(void)len;
+			intp->set(netp::E_EOPNOTSUPP);
+		}
+
 		virtual void ch_close_read_impl(NRP<promise<int>> const& chp) = 0;
 		virtual void ch_close_write_impl(NRP<promise<int>> const& chp) = 0;
 		virtual void ch_close_impl(NRP<promise<int>> const& chp) = 0;
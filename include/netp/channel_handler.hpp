@@ -27,6 +27,7 @@ namespace netp {
 		CH_OUTBOUND_CLOSE_WRITE	= 1 << 11,
 
 		CH_OUTBOUND_WRITE_TO		= 1 << 12,
+		CH_ACTIVITY_WRITABILITY_CHANGED = 1 << 13, //not a part of CH_ACTIVITY, a handler has to opt in
 		CH_CTX_DEATTACHED = 1 << 14,
 
 		CH_ACTIVITY = (CH_ACTIVITY_CONNECTED|CH_ACTIVITY_CLOSED | CH_ACTIVITY_ERROR | CH_ACTIVITY_READ_CLOSED | CH_ACTIVITY_WRITE_CLOSED ),
@@ -54,6 +55,8 @@ namespace netp {
 		virtual void error(NRP<channel_handler_context> const& ctx, int err);
 		virtual void read_closed(NRP<channel_handler_context> const& ctx);
 		virtual void write_closed(NRP<channel_handler_context> const& ctx);
+		//the outbound buffer crossed a watermark, check ctx->ch->ch_is_writable()
+		virtual void writability_changed(NRP<channel_handler_context> const& ctx);
 
 		//for inbound
 		virtual void read(NRP<channel_handler_context> const& ctx, NRP<packet> const& income);
@@ -81,6 +84,7 @@ namespace netp {
 		{}
 	protected:
 		void write(NRP<promise<int>> const& intp, NRP<channel_handler_context> const& ctx, NRP<packet> const& outlet) ;
+		void flush(NRP<channel_handler_context> const& ctx);
 		void close(NRP<promise<int>> const& intp, NRP<channel_handler_context> const& ctx );
 		void close_read(NRP<promise<int>> const& intp, NRP<channel_handler_context> const& ctx );
 		void close_write(NRP<promise<int>> const& intp, NRP<channel_handler_context> const& ctx);
@@ -93,7 +97,7 @@ namespace netp {
 	{
 	public:
 		channel_handler_tail() :
-			channel_handler_abstract(CH_ACTIVITY|CH_INBOUND)
+			channel_handler_abstract(CH_ACTIVITY|CH_ACTIVITY_WRITABILITY_CHANGED|CH_INBOUND)
 		{}
 	protected:
 		void connected(NRP<channel_handler_context> const& ctx);
@@ -101,6 +105,7 @@ namespace netp {
 		void error(NRP<channel_handler_context> const& ctx, int err);
 		void read_closed(NRP<channel_handler_context> const& ctx);
 		void write_closed(NRP<channel_handler_context> const& ctx);
+		void writability_changed(NRP<channel_handler_context> const& ctx);
 
 		void read(NRP<channel_handler_context> const& ctx, NRP<packet> const& income) ;
 		void readfrom(NRP<channel_handler_context> const& ctx, NRP<packet> const& income, NRP<address> const& from);
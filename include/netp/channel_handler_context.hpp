@@ -176,6 +176,21 @@ public:\
 	CHANNEL_HANDLER_CONTEXT_ITERATE_CTX(HANDLER_FLAG,P) \
 	_ctx->H->NAME(_ctx); \
 
+#define CH_ACTION_HANDLER_CONTEXT_IMPL_T_TO_H_VOID(NAME,HANDLER_FLAG) \
+private:\
+	inline void __##NAME() { \
+		if( NETP_UNLIKELY(H_FLAG&CH_CTX_DEATTACHED) ) {\
+			return; \
+		} \
+		CH_PROMISE_INVOKE_PREV(NAME,HANDLER_FLAG) \
+	} \
+public:\
+	inline void NAME() { \
+		L->execute([ctx=NRP<channel_handler_context>(this)]() { \
+			ctx->__##NAME(); \
+		}); \
+	} \
+
 //--T_TO_H--END
 
 namespace netp {
@@ -212,12 +227,14 @@ namespace netp {
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_0(closed, CH_ACTIVITY_CLOSED)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_0(read_closed, CH_ACTIVITY_READ_CLOSED)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_0(write_closed, CH_ACTIVITY_WRITE_CLOSED)
+		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_0(writability_changed, CH_ACTIVITY_WRITABILITY_CHANGED)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_INT_1(error, CH_ACTIVITY_ERROR)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_PACKET_1(read, CH_INBOUND_READ)
 
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_PACKET_ADDR(readfrom, CH_INBOUND_READ_FROM)
 
 		CH_PROMISE_ACTION_HANDLER_CONTEXT_IMPL_T_TO_H_PACKET_CH_PROMISE(write, CH_OUTBOUND_WRITE)
+		CH_ACTION_HANDLER_CONTEXT_IMPL_T_TO_H_VOID(flush, CH_OUTBOUND_FLUSH)
 		CH_PROMISE_ACTION_HANDLER_CONTEXT_IMPL_T_TO_H_PROMISE(close, CH_OUTBOUND_CLOSE)
 		CH_PROMISE_ACTION_HANDLER_CONTEXT_IMPL_T_TO_H_PROMISE(close_read, CH_OUTBOUND_CLOSE_READ)
 		CH_PROMISE_ACTION_HANDLER_CONTEXT_IMPL_T_TO_H_PROMISE(close_write, CH_OUTBOUND_CLOSE_WRITE)
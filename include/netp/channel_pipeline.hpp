@@ -57,6 +57,11 @@
 		return intp; \
 	}\
 
+#define PIPELINE_VOID_ACTION_VOID(NAME) \
+	__NETP_FORCE_INLINE void NAME() {\
+		m_tail->NAME(); \
+	}\
+
 #define PIPELINE_VOID_ACTION_CH_PROMISE_1(NAME) \
 	__NETP_FORCE_INLINE void NAME( NRP<promise<int>> const& intp) {\
 		m_tail->NAME(intp); \
@@ -107,12 +112,26 @@ namespace netp {
 			return p;
 		}
 
+		//true if a handler takes write, it might transform the bytes (tls, websocket, codec)
+		bool has_outbound_write() const {
+			NETP_ASSERT(m_loop->in_event_loop());
+			NRP<channel_handler_context> ctx = m_head->N;
+			while (ctx != m_tail) {
+				if ((ctx->H_FLAG&(CH_OUTBOUND_WRITE|CH_CTX_DEATTACHED)) == CH_OUTBOUND_WRITE) {
+					return true;
+				}
+				ctx = ctx->N;
+			}
+			return false;
+		}
+
 	protected:
 		PIPELINE_VOID_FIRE_VOID(connected)
 		PIPELINE_VOID_FIRE_VOID(closed)
 		PIPELINE_VOID_FIRE_INT_1(error)
 		PIPELINE_VOID_FIRE_VOID(read_closed)
 		PIPELINE_VOID_FIRE_VOID(write_closed)
+		PIPELINE_VOID_FIRE_VOID(writability_changed)
 
 		PIPELINE_VOID_FIRE_PACKET_1(read)
 
@@ -120,6 +139,7 @@ namespace netp {
 
 		PIPELINE_ACTION_PACKET(write)
 		PIPELINE_ACTION_PACKET_ADDR(write_to)
+		PIPELINE_VOID_ACTION_VOID(flush)
 
 		PIPELINE_CH_FUTURE_ACTION_VOID(close)
 		PIPELINE_CH_FUTURE_ACTION_VOID(close_read)
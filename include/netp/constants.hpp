@@ -532,6 +532,7 @@ const int  E_ERANGE = -34;         /* Result too large */
 	const int E_CHANNEL_OVERLAPPED_OP_TRY = -34017;
 	const int E_CHANNEL_MISSING_MAKER = -34018;//custom socket channel must have its own maker
 	const int E_CHANNEL_HANDLER_INVALID_STATE = -34019;
+	const int E_CHANNEL_FILE_EOF = -34020; //ch_write_file reached the end of file before len bytes were sent
 
 	const int E_DNS_CARES_ERRNO_BEGIN				= -35000;
 	const int E_DNS_LOOKUP_RETURN_NO_IP			= -36001;
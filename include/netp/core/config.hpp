@@ -72,6 +72,7 @@
 
 #define NETP_ENABLE_EPOLL
 #define NETP_ENABLE_KQUEUE
+#define NETP_ENABLE_IO_URING
 
 //#ifndef NETP_DISABLE_IOCP
 //	#define NETP_ENABLE_IOCP
@@ -88,11 +89,31 @@
 	#define NETP_HAS_POLLER_SELECT
 #endif
 
+//io_uring is an alternative of epoll, selected by event_loop_cfg::type
+#if defined(NETP_ENABLE_IO_URING) && defined(NETP_HAS_POLLER_EPOLL) && defined(_NETP_GNU_LINUX) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>)
+		#define NETP_HAS_POLLER_IO_URING
+		#define NETP_IO_URING_ENTRIES				(1024)	///< sqe count, the cq is twice of it
+	#endif
+#endif
+
 // for epoll using
 #ifdef NETP_ENABLE_EPOLL
 	#define NETP_EPOLL_CREATE_HINT_SIZE			(1024)	///< max size of epoll control
 	#define NETP_EPOLL_PER_HANDLE_SIZE			(128)	///< max size of per epoll_wait
-#endif
+	#define NETP_EPOLL_TIMERFD_SLACK			(5000)	///< in nano, an armed timerfd this close to the new deadline is not rearmed
+#endif
+
+//max datagram count per recvmmsg
+#define NETP_SOCKET_RCV_BATCH_MAX (64)
+//per datagram buffer size for batched udp read, a udp payload never exceed 64k
+#define NETP_SOCKET_RCV_BATCH_BUF_SIZE (64*1024)
+//max datagram count per sendmmsg
+#define NETP_SOCKET_SND_BATCH_MAX (64)
+//size class of the adaptive stream read buffer, class i holds (1<<(i+8)) bytes with the packet reserve, 128 ~ 1M for data
+#define NETP_SOCKET_RCV_SIZER_CLASS_MAX (12)
+//the first read is about 2k
+#define NETP_SOCKET_RCV_SIZER_CLASS_INIT (3)
 
 //#define NETP_ENABLE_TASK_TRACK
 #ifdef NETP_ENABLE_TRACK_TASK
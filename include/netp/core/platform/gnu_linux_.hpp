@@ -19,6 +19,7 @@
 #include <sys/un.h> //sockaddr_un
 #include <sys/uio.h>
 #include <sys/ioctl.h>
+#include <sys/eventfd.h>
 
 #include <linux/version.h>
 
@@ -29,7 +30,7 @@
 #define NETP_CLOSE_SOCKET	::close
 #define NETP_DUP						dup
 #define NETP_DUP2					dup2
-#define NETP_USE_PIPE_AS_INTRFD				1
+#define NETP_USE_EVENTFD_AS_INTRFD			1
 
 #define netp_last_errno() NETP_NEGATIVE((int)errno)
 #define netp_set_last_errno(e) (errno=(NETP_ABS(e)))
@@ -8,9 +8,13 @@
 #include <netp/string.hpp>
 #include <netp/smart_ptr.hpp>
 #include <netp/mutex.hpp>
+#include <netp/mpsc_queue.hpp>
+#include <netp/task.hpp>
+#include <netp/histogram.hpp>
 
 #include <netp/promise.hpp>
 #include <netp/packet.hpp>
+#include <netp/address.hpp>
 #include <netp/poller_abstract.hpp>
 #include <netp/timer.hpp>
 #include <netp/dns_resolver.hpp>
@@ -29,12 +33,35 @@
 #error "unknown poller type"
 #endif
 
-//#define NETP_DEBUG_LOOP_TIME
+//the socket_channel of the default maker runs on these ones
+#if defined(NETP_HAS_POLLER_IO_URING)
+#define NETP_IS_SOCKET_POLLER_TYPE(t) (((t) == NETP_DEFAULT_POLLER_TYPE) || ((t) == netp::io_poller_type::T_IO_URING))
+#else
+#define NETP_IS_SOCKET_POLLER_TYPE(t) ((t) == NETP_DEFAULT_POLLER_TYPE)
+#endif
+
+//event_loop::busy_ratio() is an average over about this window
+#define NETP_LOOP_BUSY_WINDOW_NS (100LL*1000LL*1000LL)
+
+//the task cells of a loop, allocated with the loop, schedule() stores a task in a cell by value
+//the tasks queued beyond it spill to the overflow of the queue, which allocates
+#define NETP_LOOP_TASK_QUEUE_SIZE 1024
 
 namespace netp {
 
 	typedef std::function<void()> fn_task_t;
-	typedef std::vector<fn_task_t, netp::allocator<fn_task_t>> io_task_q_t;
+	typedef mpsc_queue<task> io_task_q_t;
+	typedef std::vector<NRP<netp::packet>, netp::allocator<NRP<netp::packet>>> rcv_batch_buf_vector_t;
+	typedef std::vector<NRP<netp::address>, netp::allocator<NRP<netp::address>>> rcv_batch_addr_vector_t;
+
+	//how event_loop_group::next() picks a loop
+	enum event_loop_select_policy {
+		LSP_ROUND_ROBIN,
+		LSP_LEAST_IO_CTX, //the least io_ctx_count(), the scan starts at a random loop so a burst over the equal ones still spreads
+		LSP_LEAST_BUSY, //the least busy_ratio()
+		LSP_POWER_OF_TWO, //two random loops, the one with less io_ctx_count() (then busy_ratio()), no herding on a stale count
+		LSP_MAX
+	};
 
 	enum event_loop_flag {
 		f_th_thread_affinity =1<<0,
@@ -49,7 +76,9 @@ namespace netp {
 			flag(flag_),
 			thread_affinity(0),
 			no_wait_us(1),
-			channel_read_buf_size(read_buf_)
+			channel_read_buf_size(read_buf_),
+			spin_us(0),
+			select_policy(LSP_ROUND_ROBIN)
 		{}
 
 		//u16_t no_wait_us wide used construct 
@@ -58,7 +87,9 @@ namespace netp {
 			flag(flag_),
 			thread_affinity(0),
 			no_wait_us(u8_t(no_wait_us_)),
-			channel_read_buf_size(read_buf_)
+			channel_read_buf_size(read_buf_),
+			spin_us(0),
+			select_policy(LSP_ROUND_ROBIN)
 		{}
 
 		u8_t type;
@@ -66,9 +97,56 @@ namespace netp {
 		u8_t thread_affinity;
 		u8_t no_wait_us;
 		u32_t channel_read_buf_size;
+		//latency mode: keep polling with zero timeout for spin_us after the last io event|task before blocking in the poller, 0 means off
+		u32_t spin_us;
+		//event_loop_select_policy of the group
+		u8_t select_policy;
 		std::vector<netp::string_t, netp::allocator<netp::string_t>> dns_hosts;
 	};
 
+	struct event_loop_poll_stat {
+		u64_t spin_polls; //zero timeout polls made by the spin budget
+		u64_t spin_hits; //spin polls that got io events
+		u64_t sleep_polls; //polls that blocked in the poller
+		u64_t sleep_hits; //blocked polls woken up before the timeout
+		u64_t poller_ctls; //interest changes issued to the kernel, epoll_ctl for epoll
+	};
+
+	//in nano unless noted, one record per loop iteration
+	struct event_loop_latency_stat {
+		u64_t wakeups; //blocked polls interrupted by a task from another thread
+		histogram task_ns; //running the tasks, the iterations that ran none are not recorded
+		histogram task_depth; //tasks run by the iteration, the depth of the queue at its start, recorded along with task_ns
+		histogram timer_ns; //timer expiry
+		histogram poll_ns; //in the poller till the wait returns, the pending interest changes included
+		histogram io_ns; //the io callbacks dispatched by the poller
+		histogram ready_events; //ready events returned by the poll
+
+		event_loop_latency_stat() :
+			wakeups(0)
+		{}
+
+		void reset() {
+			wakeups = 0;
+			task_ns.reset();
+			task_depth.reset();
+			timer_ns.reset();
+			poll_ns.reset();
+			io_ns.reset();
+			ready_events.reset();
+		}
+
+		void merge(event_loop_latency_stat const& other) {
+			wakeups += other.wakeups;
+			task_ns.merge(other.task_ns);
+			task_depth.merge(other.task_depth);
+			timer_ns.merge(other.timer_ns);
+			poll_ns.merge(other.poll_ns);
+			io_ns.merge(other.io_ns);
+			ready_events.merge(other.ready_events);
+		}
+	};
+
 	class event_loop;
 	typedef std::function<NRP<event_loop>(event_loop_cfg const& cfg) > fn_event_loop_maker_t;
 	extern NRP<event_loop> default_event_loop_maker(event_loop_cfg const& cfg);
@@ -106,18 +184,35 @@ namespace netp {
 		NRP<timer_broker> m_tb;
 		NRP<dns_resolver> m_dns_resolver;
 		NRP<netp::packet> m_channel_rcv_buf;
+		NRP<netp::packet> m_channel_rcv_spare;
+		rcv_batch_buf_vector_t m_channel_rcv_batch_buf;
+		rcv_batch_addr_vector_t m_channel_rcv_batch_addr;
 		NRP<netp::thread> m_th;
 
-		int m_io_ctx_count;
+		std::atomic<int> m_io_ctx_count; //written by the loop thread only
 		int m_io_ctx_count_before_running;
 		std::atomic<long> m_internal_ref_count;
-#ifdef NETP_DEBUG_LOOP_TIME
-		long long m_loop_last_tp;
-		long long m_last_wait;
-#endif
+		std::atomic<i64_t> m_poll_begin_ns; //steady clock, written by the loop thread only
+		std::atomic<u32_t> m_busy_ratio; //in 1/65536, written by the loop thread only
+		double m_busy_avg; //the source of m_busy_ratio
+		i64_t m_spin_until; //steady clock in nano, 0 means not spinning
+		bool m_spinning; //the current poll is a spin poll
+
+		//written by the loop thread only
+		std::atomic<u64_t> m_stat_spin_polls;
+		std::atomic<u64_t> m_stat_spin_hits;
+		std::atomic<u64_t> m_stat_sleep_polls;
+		std::atomic<u64_t> m_stat_sleep_hits;
+
+		//written by the loop thread only but m_stat_wakeups, see event_loop_latency_stat
+		std::atomic<u64_t> m_stat_wakeups;
+		atomic_histogram m_lat_task_ns;
+		atomic_histogram m_lat_task_depth;
+		atomic_histogram m_lat_timer_ns;
+		atomic_histogram m_lat_poll_ns;
+		atomic_histogram m_lat_io_ns;
+		atomic_histogram m_lat_ready_events;
 
-		spin_mutex m_tq_mutex;
-		io_task_q_t m_tq_standby;
 		io_task_q_t m_tq;
 
 		//timer_timepoint_t m_wait_until;
@@ -130,45 +225,50 @@ namespace netp {
 		inline long internal_ref_count() { return m_internal_ref_count.load(std::memory_order_relaxed); }
 		inline void store_internal_ref_count( long count ) { m_internal_ref_count.store( count, std::memory_order_relaxed); }
 		inline void inc_internal_ref_count() { m_internal_ref_count.fetch_add(1, std::memory_order_relaxed); }
+		inline void dec_internal_ref_count() { m_internal_ref_count.fetch_sub(1, std::memory_order_relaxed); }
 
 		//0,	NO WAIT
 		//~0,	INFINITE WAIT
 		//>0,	WAIT nanosecond
-		i64_t _calc_wait_dur_in_nano() {
+		//ndelayns: the delay to the next timer, now_ns: the steady clock in nano
+		i64_t _calc_wait_dur_in_nano(i64_t ndelayns, i64_t now_ns) {
 			NETP_ASSERT( m_waiting.load(std::memory_order_relaxed) == false, "_calc_wait_dur_in_nano waiting check failed" );
 			static_assert(TIMER_TIME_INFINITE == i64_t(-1), "timer infinite check");
-			netp::timer_duration_t ndelay;
-			m_tb->expire(ndelay);
-			i64_t ndelayns = i64_t(ndelay.count());
 			//@note: opt for select, epoll_wait
 			//@note: select, epoll_wait cost too much time to return (ms level)
 			if ( (ndelayns != TIMER_TIME_INFINITE) && (ndelayns <= (i64_t(m_cfg.no_wait_us)*1000LL)) ) {
 				//less than 1us
-#ifdef NETP_DEBUG_LOOP_TIME
-				m_last_wait = 0;
-#endif
 				return 0;
 			}
 
-			{
-				lock_guard<spin_mutex> lg(m_tq_mutex);
-				if (m_tq_standby.size() != 0) {
-#ifdef NETP_DEBUG_LOOP_TIME
-					m_last_wait = 0;
-#endif
+			//@note: in latency mode, we trade cpu for the wakeup cost of a blocked poll
+			if (m_spin_until != 0) {
+				if (now_ns < m_spin_until) {
+					m_spinning = true;
 					return 0;
 				}
-				NETP_POLLER_WAIT_ENTER(m_waiting);
+				m_spin_until = 0;
+			}
+
+			//@note: pairs with schedule(), either the producer sees m_waiting or we see its task
+			m_waiting.store(true, std::memory_order_seq_cst);
+			if (!m_tq.empty()) {
+				m_waiting.store(false, std::memory_order_relaxed);
+				return 0;
 			}
-#ifdef NETP_DEBUG_LOOP_TIME
-			m_last_wait = ndelayns;
-#endif
 			return ndelayns;
 		}
 
 		virtual void init();
 		virtual void deinit();
 
+		__NETP_FORCE_INLINE
+		static void __stat_incre(std::atomic<u64_t>& stat) {
+			stat.store(stat.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		void __poll_stat_update(i64_t wait_in_nano, int nevents, bool has_task, i64_t now_ns);
+		void __busy_ratio_update(i64_t iteration_ns, i64_t wait_ns);
+
 		void __run();
 		void __do_notify_terminating();
 		void __notify_terminating();		
@@ -187,6 +287,37 @@ namespace netp {
 		__NETP_FORCE_INLINE
 		u8_t poller_type() const { return m_cfg.type; }
 
+		event_loop_poll_stat poll_stat() const {
+			return event_loop_poll_stat{
+				m_stat_spin_polls.load(std::memory_order_relaxed),
+				m_stat_spin_hits.load(std::memory_order_relaxed),
+				m_stat_sleep_polls.load(std::memory_order_relaxed),
+				m_stat_sleep_hits.load(std::memory_order_relaxed),
+				m_poller->ctl_count()
+			};
+		}
+
+		//thread safe, lock free
+		void latency_snapshot(event_loop_latency_stat& o) const;
+
+		//thread safe, the io_ctx of the loop, the internal ones (dns resolver) included
+		__NETP_FORCE_INLINE
+		int io_ctx_count() const { return m_io_ctx_count.load(std::memory_order_relaxed); }
+
+		//thread safe, the share of the recent wall time out of the poll wait, in 1/65536
+		//it is updated at the end of every iteration, a loop blocked in the poller decays it by the time it has waited
+		u32_t busy_ratio(i64_t now_ns) const {
+			const u32_t r = m_busy_ratio.load(std::memory_order_relaxed);
+			if (!m_waiting.load(std::memory_order_relaxed)) {
+				return r;
+			}
+			const i64_t idle = now_ns - m_poll_begin_ns.load(std::memory_order_relaxed);
+			if (idle <= 0) {
+				return r;
+			}
+			return idle >= NETP_LOOP_BUSY_WINDOW_NS ? 0 : u32_t((u64_t(r) * u64_t(NETP_LOOP_BUSY_WINDOW_NS - idle)) / u64_t(NETP_LOOP_BUSY_WINDOW_NS));
+		}
+
 		__NETP_FORCE_INLINE
 		NRP<netp::packet>& channel_rcv_buf() {
 			return m_channel_rcv_buf;
@@ -197,12 +328,53 @@ namespace netp {
 			return m_cfg.channel_read_buf_size;
 		}
 
+		//an empty buffer left by the last adaptive read that got nothing, the next adaptive read of the same size takes it
+		__NETP_FORCE_INLINE
+		NRP<netp::packet>& channel_rcv_spare() {
+			return m_channel_rcv_spare;
+		}
+
+		//slots for batched datagram read, a slot is refilled on demand once it has been handed to the channel
+		__NETP_FORCE_INLINE
+		NRP<netp::packet>& channel_rcv_batch_buf(u32_t idx) {
+			NETP_ASSERT(idx < NETP_SOCKET_RCV_BATCH_MAX);
+			NRP<netp::packet>& buf = m_channel_rcv_batch_buf[idx];
+			if (buf == nullptr) {
+				buf = netp::make_ref<netp::packet>(channel_rcv_batch_buf_size());
+			}
+			return buf;
+		}
+
+		__NETP_FORCE_INLINE
+		u32_t channel_rcv_batch_buf_size() const {
+			return m_cfg.channel_read_buf_size < NETP_SOCKET_RCV_BATCH_BUF_SIZE ? m_cfg.channel_read_buf_size : NETP_SOCKET_RCV_BATCH_BUF_SIZE;
+		}
+
+		__NETP_FORCE_INLINE
+		NRP<netp::address>& channel_rcv_batch_addr(u32_t idx) {
+			NETP_ASSERT(idx < NETP_SOCKET_RCV_BATCH_MAX);
+			NRP<netp::address>& addr = m_channel_rcv_batch_addr[idx];
+			if (addr == nullptr) {
+				addr = netp::make_ref<netp::address>();
+			}
+			return addr;
+		}
+
 		__NETP_FORCE_INLINE
 		NRP<dns_query_promise> resolve(string_t const& domain) {
 			NETP_ASSERT(m_cfg.flag & f_enable_dns_resolver);
 			return m_dns_resolver->resolve(domain);
 		}
 
+		//@note: only the first producer that sees the loop waiting interrupts it, m_waiting is cleared by the xchg
+		//the loop clears it as well once poll returns, the others find it false and skip the syscall
+		__NETP_FORCE_INLINE void _interrupt_if_waiting() {
+			if (!in_event_loop() && m_waiting.load(std::memory_order_seq_cst) && m_waiting.exchange(false, std::memory_order_acq_rel)) {
+				m_stat_wakeups.fetch_add(1, std::memory_order_relaxed);
+				m_poller->interrupt_wait();
+			}
+		}
+
 //#define _NETP_DUMP_SCHEDULE_COST
 		/*win10 output
 		[event_loop]schedule, cost: 122800 ns, interrupted: 1
@@ -223,45 +395,22 @@ namespace netp {
 		[event_loop]schedule, cost: 47000 ns, interrupted: 1
 		[event_loop]schedule, cost: 100 ns, interrupted: 0
 		*/
-		inline void schedule(fn_task_t&& f) {
-			//NOTE: upate on 2021/04/03
-			//lock_guard of m_tq_mutex also works as a memory barrier for memory accesses across loops in between task caller and task callee
-
-			//NOTE: update on 2021/03/28
-			//lock_guard of m_tq_mutex would pose a load/store memory barrier at least
-			//these kinds of barrier could make sure that the compiler would not reorder the instruction around the barrier, so interrupt_poller would always have a false initial value
-			//as  a per thread variable, the reorder brought by CPU should not be a issue for _interrupt_poller
+		//@note: a lambda converts to netp::task in place, the common ones are stored inline, the task is moved into a preallocated cell of m_tq
+		//no allocation is made unless the lambda is too large to be inline or more than NETP_LOOP_TASK_QUEUE_SIZE tasks are pending
+		inline void schedule(task&& f) {
+			//@note: the release store of the cell's sequence in push and the acquire load in consume order the memory accesses of the caller before the task
 #ifdef _NETP_DUMP_SCHEDULE_COST
 			long long __begin = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
 #endif
-			bool _interrupt_poller = false;
-			{
-				lock_guard<spin_mutex> lg(m_tq_mutex);
-				m_tq_standby.emplace_back(std::move(f));
-				_interrupt_poller=( m_tq_standby.size() == 1 && !in_event_loop() && m_waiting.load(std::memory_order_relaxed));
-			}
-			if (_interrupt_poller) {
-				m_poller->interrupt_wait();
-			}
+			m_tq.push(std::move(f));
+			_interrupt_if_waiting();
 #ifdef _NETP_DUMP_SCHEDULE_COST
 			long long __end = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
-			printf("[event_loop]schedule, cost: %llu ns, interrupted: %d\n", __end - __begin, _interrupt_poller);
+			printf("[event_loop]schedule, cost: %llu ns\n", __end - __begin);
 #endif
 		}
 
-		inline void schedule(fn_task_t const& f) {
-			bool _interrupt_poller = false;
-			{
-				lock_guard<spin_mutex> lg(m_tq_mutex);
-				m_tq_standby.push_back(f);
-				_interrupt_poller=( m_tq_standby.size() == 1 && !in_event_loop() && m_waiting.load(std::memory_order_relaxed));
-			}
-			if (NETP_UNLIKELY(_interrupt_poller)) {
-				m_poller->interrupt_wait();
-			}
-		}
-
-		inline void execute(fn_task_t&& f) {
+		inline void execute(task&& f) {
 			if (in_event_loop()) {
 				f();
 				return;
@@ -269,14 +418,6 @@ namespace netp {
 			schedule(std::move(f));
 		}
 
-		inline void execute(fn_task_t const& f) {
-			if (in_event_loop()) {
-				f();
-				return;
-			}
-			schedule(f);
-		}
-
 		__NETP_FORCE_INLINE
 		const bool in_event_loop() const {
 			/*
@@ -341,7 +482,7 @@ namespace netp {
 			if (m_state.load(std::memory_order_acquire) < u8_t(loop_state::S_TERMINATING)) {
 				io_ctx* _ctx= m_poller->io_begin(fd, iom);
 				if (NETP_LIKELY(_ctx != nullptr)) {
-					++m_io_ctx_count;
+					m_io_ctx_count.store(m_io_ctx_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 				}
 				return _ctx;
 			}
@@ -353,7 +494,9 @@ namespace netp {
 #endif
 			m_poller->io_end(ctx);
 
-			if ( (--m_io_ctx_count == m_io_ctx_count_before_running) && m_state.load(std::memory_order_acquire) == u8_t(loop_state::S_TERMINATING)) {
+			const int count = m_io_ctx_count.load(std::memory_order_relaxed) - 1;
+			m_io_ctx_count.store(count, std::memory_order_relaxed);
+			if ( (count == m_io_ctx_count_before_running) && m_state.load(std::memory_order_acquire) == u8_t(loop_state::S_TERMINATING)) {
 				__do_enter_terminated();
 			}
 		}
@@ -361,6 +504,22 @@ namespace netp {
 
 	class app;
 	typedef std::vector<NRP<event_loop>, netp::allocator<NRP<event_loop>>> event_loop_vector_t;
+
+	//@note: an immutable copy of the running loops, next() reads it without a lock, its refs are counted in the internal ref count of the loops
+	//a reader copies a loop inside a read section, a replaced snapshot is trashed once the readers of the old epoch have left
+	//the detach of a loop trusts the ref count only after that
+	struct event_loop_snapshot {
+		event_loop_vector_t L;
+	};
+
+	//a reader counts itself in the slot of its thread, a counter of a slot is 64 bytes away from the ones of the next slot
+	//the threads over NETP_LOOP_GROUP_READER_SLOTS share a slot
+	#define NETP_LOOP_GROUP_READER_SLOTS 64
+	struct event_loop_reader_slot {
+		std::atomic<u32_t> n[2]; //the readers of the even|odd epoch
+		u8_t __pad[64 - sizeof(std::atomic<u32_t>) * 2];
+	};
+
 	class event_loop_group:
 		public non_atomic_ref_base
 	{
@@ -373,9 +532,18 @@ namespace netp {
 		};
 
 	private:
+		//guards m_loop for the writers
 		netp::shared_mutex m_loop_mtx;
 		std::atomic<u32_t> m_curr_loop_idx;
 		event_loop_vector_t m_loop;
+		u8_t __pad0[64];
+		//read mostly, written by a detach only
+		std::atomic<event_loop_snapshot*> m_snapshot;
+		std::atomic<u8_t> m_select_policy;
+		//the readers of the current epoch are counted in m_reader_slots[i].n[epoch&1]
+		std::atomic<u32_t> m_reader_epoch;
+		u8_t __pad1[64];
+		event_loop_reader_slot m_reader_slots[NETP_LOOP_GROUP_READER_SLOTS];
 
 		std::atomic<bye_event_loop_state> m_bye_state;
 		NRP<event_loop> m_bye_event_loop;
@@ -384,6 +552,13 @@ namespace netp {
 		fn_event_loop_maker_t m_fn_loop_maker;
 
 		void _wait_loop();
+		event_loop_snapshot* _publish_snapshot();
+		void _trash_snapshot(event_loop_snapshot* s);
+		std::atomic<u32_t>* _read_enter();
+		void _read_leave(std::atomic<u32_t>* n);
+		void _wait_readers();
+		NRP<event_loop> _bye_loop();
+		u32_t _select(event_loop_vector_t const& L, std::set<NRP<event_loop>> const* exclude);
 	public:
 		event_loop_group(event_loop_cfg const& cfg, fn_event_loop_maker_t const& fn_maker);
 		~event_loop_group();
@@ -395,12 +570,20 @@ namespace netp {
 		void stop();
 
 		netp::size_t size();
+		//copy of the running loops, empty once the group is stopped
+		event_loop_vector_t loops();
+
+		//event_loop_select_policy, thread safe
+		void set_select_policy(u8_t policy);
+		inline u8_t select_policy() const { return m_select_policy.load(std::memory_order_relaxed); }
+		//merge of the latency_snapshot of the running loops
+		void latency_snapshot(event_loop_latency_stat& o);
 
 		NRP<event_loop> next(std::set<NRP<event_loop>> const& exclude_this_set_if_have_more);
 		NRP<event_loop> next();
 
-		void execute(fn_task_t&& f);
-		void schedule(fn_task_t&& f);
+		void execute(task&& f);
+		void schedule(task&& f);
 		void launch(NRP<netp::timer> const& t, NRP<netp::promise<int>> const& lf = nullptr);
 	};
 }
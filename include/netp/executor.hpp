@@ -0,0 +1,269 @@
+#ifndef _NETP_EXECUTOR_HPP
+#define _NETP_EXECUTOR_HPP
+
+#include <atomic>
+#include <vector>
+#include <tuple>
+
+#include <netp/core.hpp>
+#include <netp/smart_ptr.hpp>
+#include <netp/memory.hpp>
+#include <netp/mutex.hpp>
+#include <netp/task.hpp>
+#include <netp/mpsc_queue.hpp>
+#include <netp/promise.hpp>
+#include <netp/event_loop.hpp>
+
+namespace netp {
+
+	enum executor_priority {
+		EP_HIGH = 0,
+		EP_NORMAL,
+		EP_MAX
+	};
+
+	//@note: Chase-Lev work stealing deque (Le, Pop, Cohen, Nardelli, PPoPP 2013)
+	//push and pop by the owner at the bottom, steal by the others at the top
+	//a grown array is kept till the deque is destroyed, a thief might still read from it
+	class ws_deque final {
+		NETP_DECLARE_NONCOPYABLE(ws_deque)
+
+		struct ws_array {
+			i64_t cap;
+			std::atomic<task*>* buf;
+			ws_array* retired;
+
+			ws_array(i64_t cap_, ws_array* retired_) :
+				cap(cap_),
+				buf(netp::allocator<std::atomic<task*>>::make_array(size_t(cap_))),
+				retired(retired_)
+			{
+				NETP_ALLOC_CHECK(buf, sizeof(std::atomic<task*>) * size_t(cap_));
+			}
+			~ws_array() {
+				netp::allocator<std::atomic<task*>>::trash_array(buf, size_t(cap));
+			}
+			__NETP_FORCE_INLINE task* get(i64_t i) const { return buf[i & (cap - 1)].load(std::memory_order_relaxed); }
+			__NETP_FORCE_INLINE void put(i64_t i, task* t) { buf[i & (cap - 1)].store(t, std::memory_order_relaxed); }
+		};
+
+		std::atomic<i64_t> m_top;
+		u8_t __pad0[64 - sizeof(std::atomic<i64_t>)];
+		std::atomic<i64_t> m_bottom;
+		std::atomic<ws_array*> m_array;
+
+		ws_array* _grow(ws_array* a, i64_t top, i64_t bottom) {
+			ws_array* na = netp::allocator<ws_array>::make(a->cap << 1, a);
+			NETP_ALLOC_CHECK(na, sizeof(ws_array));
+			for (i64_t i = top; i < bottom; ++i) {
+				na->put(i, a->get(i));
+			}
+			m_array.store(na, std::memory_order_release);
+			return na;
+		}
+
+	public:
+		explicit ws_deque(i64_t cap = 256) :
+			m_top(0),
+			m_bottom(0),
+			m_array(nullptr)
+		{
+			NETP_ASSERT(cap > 0 && ((cap & (cap - 1)) == 0));
+			ws_array* a = netp::allocator<ws_array>::make(cap, nullptr);
+			NETP_ALLOC_CHECK(a, sizeof(ws_array));
+			m_array.store(a, std::memory_order_relaxed);
+		}
+
+		~ws_deque() {
+			ws_array* a = m_array.load(std::memory_order_relaxed);
+			while (a != nullptr) {
+				ws_array* r = a->retired;
+				netp::allocator<ws_array>::trash(a);
+				a = r;
+			}
+		}
+
+		//owner only
+		void push(task* t) {
+			const i64_t b = m_bottom.load(std::memory_order_relaxed);
+			const i64_t top = m_top.load(std::memory_order_acquire);
+			ws_array* a = m_array.load(std::memory_order_relaxed);
+			if ((b - top) > (a->cap - 1)) {
+				a = _grow(a, top, b);
+			}
+			a->put(b, t);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+
+		//owner only
+		task* pop() {
+			const i64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+			ws_array* a = m_array.load(std::memory_order_relaxed);
+			m_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			i64_t top = m_top.load(std::memory_order_relaxed);
+			if (top > b) {
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			task* t = a->get(b);
+			if (top == b) {
+				//the last one, race with the thieves
+				if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					t = nullptr;
+				}
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return t;
+		}
+
+		//thread safe, return nullptr if it is empty or another thief wins the race
+		task* steal() {
+			i64_t top = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const i64_t b = m_bottom.load(std::memory_order_acquire);
+			if (top >= b) {
+				return nullptr;
+			}
+			ws_array* a = m_array.load(std::memory_order_acquire);
+			task* t = a->get(top);
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return t;
+		}
+
+		//thread safe, a hint only
+		inline bool empty() const {
+			return m_bottom.load(std::memory_order_seq_cst) <= m_top.load(std::memory_order_seq_cst);
+		}
+	};
+
+	struct executor_stat {
+		u64_t executed;
+		u64_t stolen;
+		u64_t parks;
+	};
+
+	//the error code of a job that throws
+	template <class _Fn, class R>
+	inline int __executor_call(_Fn& fn, R& r) {
+		try {
+			r = fn();
+		} catch (netp::exception& e) {
+			return e.code();
+		} catch (...) {
+			return netp::E_UNKNOWN;
+		}
+		return netp::OK;
+	}
+
+	template <class R>
+	struct __executor_on_loop {
+		template <class _Fn, class _Then>
+		static void run(NRP<event_loop> const& L, _Fn& fn, _Then& then) {
+			R r = fn();
+			L->execute([then = std::move(then), r = std::move(r)]() mutable {
+				then(r);
+			});
+		}
+	};
+
+	template <>
+	struct __executor_on_loop<void> {
+		template <class _Fn, class _Then>
+		static void run(NRP<event_loop> const& L, _Fn& fn, _Then& then) {
+			fn();
+			L->execute([then = std::move(then)]() mutable {
+				then();
+			});
+		}
+	};
+
+	//@note: work stealing thread pool for the cpu bound jobs (compression, crypto, serialization) that should not run on the io loops
+	//every worker owns a ws_deque per priority, a task executed by a worker goes to its own deque, the others go to the injector queue shared by all the workers
+	//the injector holds the tasks by value in preallocated cells, a deque holds the task cells recycled by the worker that runs them, no task is allocated per job
+	//a worker looks for the high priority tasks of its own, the injector and the others before the normal ones, then spins a while and parks
+	//a task that throws is logged and dropped, the worker keeps running
+	class executor final :
+		public netp::ref_base
+	{
+		NETP_DECLARE_NONCOPYABLE(executor)
+
+		enum executor_state {
+			S_IDLE,
+			S_RUNNING,
+			S_EXIT
+		};
+
+	public:
+		struct worker;
+	private:
+		typedef std::vector<worker*> worker_vector_t;
+		//NETP_MPSC_QUEUE_DEF_CAPACITY cells a priority, pushed and popped under m_inj_mtx, the lock orders the pops of the workers
+		typedef netp::mpsc_queue<task> injector_q_t;
+
+		std::atomic<u8_t> m_state;
+		u32_t m_count;
+		worker_vector_t m_workers;
+		std::atomic<u32_t> m_sleepers;
+
+		//m_state is updated under m_inj_mtx by start() and stop(), no task is injected after stop()
+		spin_mutex m_inj_mtx;
+		injector_q_t m_inj[EP_MAX];
+		std::atomic<u32_t> m_inj_size[EP_MAX];
+
+		void _run(worker* w);
+		task* _cell_make(worker* w);
+		void _cell_recycle(worker* w, task* t);
+		task* _inj_pop(worker* w, u8_t priority);
+		task* _find(worker* w);
+		bool _has_work() const;
+		void _park(worker* w);
+		void _unpark(worker* w);
+		void _unpark_one();
+
+	public:
+		//0 means std::thread::hardware_concurrency()
+		explicit executor(u32_t count = 0);
+		~executor();
+
+		int start();
+		//the queued tasks and the ones they execute run to the end before the workers exit
+		void stop();
+
+		inline u32_t worker_count() const { return m_count; }
+		executor_stat stat() const;
+
+		//thread safe, return E_INVALID_OPERATION if it is called by a non-worker thread before start() or after stop(), t is dropped
+		int execute(task&& t, u8_t priority = EP_NORMAL);
+
+		//the promise is set on the worker with <OK, fn()>, or <error code, R()> if fn throws, or right away if execute fails
+		template <class _Fn, class R = typename std::result_of<typename std::decay<_Fn>::type()>::type>
+		NRP<promise<std::tuple<int, R>>> submit(_Fn&& fn, u8_t priority = EP_NORMAL) {
+			static_assert(!std::is_void<R>::value, "use execute() for a job without a result");
+			NRP<promise<std::tuple<int, R>>> p = netp::make_ref<promise<std::tuple<int, R>>>();
+			const int rt = execute([p, fn = std::forward<_Fn>(fn)]() mutable {
+				R r = R();
+				const int frt = __executor_call(fn, r);
+				p->set(std::make_tuple(frt, std::move(r)));
+			}, priority);
+			if (rt != netp::OK) {
+				p->set(std::make_tuple(rt, R()));
+			}
+			return p;
+		}
+
+		//run fn on a worker, then resume then(result) (or then() for a void fn) on L
+		//then is not called if fn throws
+		template <class _Fn, class _Then>
+		int execute_on_loop(NRP<event_loop> const& L, _Fn&& fn, _Then&& then, u8_t priority = EP_NORMAL) {
+			typedef typename std::result_of<typename std::decay<_Fn>::type()>::type R;
+			return execute([L, fn = std::forward<_Fn>(fn), then = std::forward<_Then>(then)]() mutable {
+				__executor_on_loop<R>::run(L, fn, then);
+			}, priority);
+		}
+	};
+}
+#endif
@@ -0,0 +1,211 @@
+#ifndef _NETP_HISTOGRAM_HPP
+#define _NETP_HISTOGRAM_HPP
+
+#include <cstring>
+#include <atomic>
+#include <netp/core.hpp>
+
+#ifdef _NETP_MSVC
+	#include <intrin.h>
+#endif
+
+//sub buckets of each power of two, 1<<3 keeps the width of a bucket in 12.5% of its lower bound
+#define NETP_HISTOGRAM_SUB_BITS (3)
+#define NETP_HISTOGRAM_SUB_COUNT (1<<NETP_HISTOGRAM_SUB_BITS)
+#define NETP_HISTOGRAM_BUCKET_COUNT (NETP_HISTOGRAM_SUB_COUNT + (64-NETP_HISTOGRAM_SUB_BITS)*NETP_HISTOGRAM_SUB_COUNT)
+
+namespace netp {
+
+	//@note: log-linear buckets of u64 values, the value under NETP_HISTOGRAM_SUB_COUNT has its own bucket
+	//every power of two above it is split into NETP_HISTOGRAM_SUB_COUNT linear buckets
+	//record() is O(1) and does not allocate, a histogram is not thread safe
+	class histogram final {
+		friend class atomic_histogram;
+
+		u64_t m_count;
+		u64_t m_sum;
+		u64_t m_min;
+		u64_t m_max;
+		u64_t m_buckets[NETP_HISTOGRAM_BUCKET_COUNT];
+
+		__NETP_FORCE_INLINE static u32_t __log2(u64_t v) {
+			NETP_ASSERT(v != 0);
+#if defined(_NETP_GCC)
+			return 63 - u32_t(__builtin_clzll(v));
+#elif defined(_NETP_MSVC) && defined(_NETP_AMW64)
+			unsigned long i;
+			_BitScanReverse64(&i, v);
+			return u32_t(i);
+#else
+			u32_t i = 0;
+			while (v >>= 1) { ++i; }
+			return i;
+#endif
+		}
+
+		__NETP_FORCE_INLINE static u32_t __bucket_of(u64_t v) {
+			if (v < NETP_HISTOGRAM_SUB_COUNT) {
+				return u32_t(v);
+			}
+			const u32_t e = __log2(v);
+			const u32_t sub = u32_t(v >> (e - NETP_HISTOGRAM_SUB_BITS)) & (NETP_HISTOGRAM_SUB_COUNT - 1);
+			return NETP_HISTOGRAM_SUB_COUNT + ((e - NETP_HISTOGRAM_SUB_BITS) << NETP_HISTOGRAM_SUB_BITS) + sub;
+		}
+
+		//the highest value that falls into bucket i
+		static u64_t __bucket_high(u32_t i) {
+			if (i < NETP_HISTOGRAM_SUB_COUNT) {
+				return i;
+			}
+			const u32_t e = ((i - NETP_HISTOGRAM_SUB_COUNT) >> NETP_HISTOGRAM_SUB_BITS) + NETP_HISTOGRAM_SUB_BITS;
+			const u64_t sub = (i & (NETP_HISTOGRAM_SUB_COUNT - 1));
+			const u64_t lo = (u64_t(NETP_HISTOGRAM_SUB_COUNT) + sub) << (e - NETP_HISTOGRAM_SUB_BITS);
+			return lo + ((u64_t(1) << (e - NETP_HISTOGRAM_SUB_BITS)) - 1);
+		}
+
+	public:
+		histogram() {
+			reset();
+		}
+
+		void reset() {
+			m_count = 0;
+			m_sum = 0;
+			m_min = ~u64_t(0);
+			m_max = 0;
+			std::memset(m_buckets, 0, sizeof(m_buckets));
+		}
+
+		__NETP_FORCE_INLINE void record(u64_t v) {
+			++m_buckets[__bucket_of(v)];
+			++m_count;
+			m_sum += v;
+			if (v < m_min) { m_min = v; }
+			if (v > m_max) { m_max = v; }
+		}
+
+		void merge(histogram const& other) {
+			if (other.m_count == 0) {
+				return;
+			}
+			for (u32_t i = 0; i < NETP_HISTOGRAM_BUCKET_COUNT; ++i) {
+				m_buckets[i] += other.m_buckets[i];
+			}
+			m_count += other.m_count;
+			m_sum += other.m_sum;
+			if (other.m_min < m_min) { m_min = other.m_min; }
+			if (other.m_max > m_max) { m_max = other.m_max; }
+		}
+
+		inline u64_t count() const { return m_count; }
+		inline u64_t sum() const { return m_sum; }
+		inline u64_t min() const { return m_count == 0 ? 0 : m_min; }
+		inline u64_t max() const { return m_max; }
+		inline double mean() const { return m_count == 0 ? 0.0 : double(m_sum) / double(m_count); }
+
+		//p in [0,100], the result is the upper bound of the bucket that holds the p-th percentile, clamped into [min,max]
+		u64_t percentile(double p) const {
+			if (m_count == 0) {
+				return 0;
+			}
+			if (p <= 0.0) {
+				return m_min;
+			}
+			if (p >= 100.0) {
+				return m_max;
+			}
+			u64_t rank = u64_t((p / 100.0) * double(m_count) + 0.5);
+			if (rank == 0) { rank = 1; }
+			u64_t seen = 0;
+			for (u32_t i = 0; i < NETP_HISTOGRAM_BUCKET_COUNT; ++i) {
+				seen += m_buckets[i];
+				if (seen >= rank) {
+					const u64_t v = __bucket_high(i);
+					return v < m_min ? m_min : (v > m_max ? m_max : v);
+				}
+			}
+			return m_max;
+		}
+	};
+
+	//@note: count, sum, min, max and the last value, no percentile, for a metric kept per object where a histogram would be too big
+	struct value_stat {
+		u64_t count;
+		u64_t sum;
+		u64_t min;
+		u64_t max;
+		u64_t last;
+
+		value_stat() :
+			count(0), sum(0), min(0), max(0), last(0)
+		{}
+
+		__NETP_FORCE_INLINE void record(u64_t v) {
+			if (count == 0 || v < min) { min = v; }
+			if (v > max) { max = v; }
+			sum += v;
+			last = v;
+			++count;
+		}
+
+		inline double mean() const { return count == 0 ? 0.0 : double(sum) / double(count); }
+	};
+
+	//@note: the same buckets with one writer thread and lock free readers on any thread
+	//a field is written by a plain load and store, a snapshot taken during a record() might see it in a part of the fields
+	//the count of a snapshot is the sum of its buckets, so its percentiles agree with each other
+	class atomic_histogram final {
+		NETP_DECLARE_NONCOPYABLE(atomic_histogram)
+
+		std::atomic<u64_t> m_sum;
+		std::atomic<u64_t> m_min;
+		std::atomic<u64_t> m_max;
+		std::atomic<u64_t> m_buckets[NETP_HISTOGRAM_BUCKET_COUNT];
+
+		__NETP_FORCE_INLINE static void __add(std::atomic<u64_t>& a, u64_t v) {
+			a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+		}
+
+	public:
+		atomic_histogram() {
+			reset();
+		}
+
+		//writer only
+		void reset() {
+			m_sum.store(0, std::memory_order_relaxed);
+			m_min.store(~u64_t(0), std::memory_order_relaxed);
+			m_max.store(0, std::memory_order_relaxed);
+			for (u32_t i = 0; i < NETP_HISTOGRAM_BUCKET_COUNT; ++i) {
+				m_buckets[i].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		//writer only, the release store of the bucket publishes min and max to a snapshot that sees it
+		__NETP_FORCE_INLINE void record(u64_t v) {
+			__add(m_sum, v);
+			if (v < m_min.load(std::memory_order_relaxed)) { m_min.store(v, std::memory_order_relaxed); }
+			if (v > m_max.load(std::memory_order_relaxed)) { m_max.store(v, std::memory_order_relaxed); }
+			std::atomic<u64_t>& b = m_buckets[histogram::__bucket_of(v)];
+			b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		//thread safe
+		void snapshot(histogram& o) const {
+			o.reset();
+			u64_t count = 0;
+			for (u32_t i = 0; i < NETP_HISTOGRAM_BUCKET_COUNT; ++i) {
+				o.m_buckets[i] = m_buckets[i].load(std::memory_order_acquire);
+				count += o.m_buckets[i];
+			}
+			if (count == 0) {
+				return;
+			}
+			o.m_count = count;
+			o.m_sum = m_sum.load(std::memory_order_relaxed);
+			o.m_min = m_min.load(std::memory_order_relaxed);
+			o.m_max = m_max.load(std::memory_order_relaxed);
+		}
+	};
+}
+#endif
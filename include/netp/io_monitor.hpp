@@ -12,6 +12,8 @@ namespace netp {
 		virtual void io_notify_terminating(int status, io_ctx*) = 0;
 		virtual void io_notify_read(int status, io_ctx* ctx) = 0;
 		virtual void io_notify_write(int status, io_ctx* ctx) = 0;
+		//the socket error queue is readable, such as a MSG_ZEROCOPY completion
+		virtual void io_notify_errqueue(int, io_ctx*) {}
 	};
 }
 
@@ -0,0 +1,204 @@
+#ifndef _NETP_MPSC_QUEUE_HPP
+#define _NETP_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <deque>
+#include <type_traits>
+
+#include <netp/core.hpp>
+#include <netp/memory.hpp>
+#include <netp/mutex.hpp>
+
+//the cells of a queue are allocated once, rounded up to a power of 2
+#define NETP_MPSC_QUEUE_DEF_CAPACITY 1024
+
+namespace netp {
+
+	//@note: multi producer single consumer queue, a ring of preallocated cells that hold the items by value (D.Vyukov's bounded queue)
+	//push claims a cell by a cas on the enqueue index and publishes it by a release store of the cell's sequence, nothing is allocated
+	//a full ring spills to an overflow deque under a spin_mutex, the pushes keep going there till the consumer has drained the ring and
+	//taken the deque, so the items of a producer are consumed in the order they were pushed
+	template <class _ItemT>
+	class mpsc_queue {
+		NETP_DECLARE_NONCOPYABLE(mpsc_queue<_ItemT>)
+
+		struct cell {
+			std::atomic<netp::size_t> seq;
+			typename std::aligned_storage<sizeof(_ItemT), alignof(_ItemT)>::type storage;
+
+			cell() : seq(0) {}
+			inline _ItemT* item() { return reinterpret_cast<_ItemT*>(&storage); }
+		};
+		typedef netp::allocator<cell> cell_allocator_t;
+		typedef std::deque<_ItemT, netp::allocator<_ItemT>> overflow_deque_t;
+
+		enum { CACHE_LINE_SIZE = 64 };
+
+		cell* m_cells;
+		netp::size_t m_mask;
+		u8_t __pad0[CACHE_LINE_SIZE - sizeof(cell*) - sizeof(netp::size_t)];
+		//producer side and consumer side on their own lines
+		std::atomic<netp::size_t> m_enq;
+		u8_t __pad1[CACHE_LINE_SIZE - sizeof(std::atomic<netp::size_t>)];
+		netp::size_t m_deq;
+		u8_t __pad2[CACHE_LINE_SIZE - sizeof(netp::size_t)];
+
+		std::atomic<bool> m_overflow;
+		spin_mutex m_overflow_mtx;
+		overflow_deque_t m_overflow_q;
+		overflow_deque_t m_overflow_run; //consumer only
+
+		template <class _ArgT>
+		__NETP_FORCE_INLINE bool _ring_push(_ArgT&& item) {
+			netp::size_t pos = m_enq.load(std::memory_order_relaxed);
+			cell* c;
+			while (1) {
+				c = m_cells + (pos & m_mask);
+				const std::ptrdiff_t diff = std::ptrdiff_t(c->seq.load(std::memory_order_acquire)) - std::ptrdiff_t(pos);
+				if (diff == 0) {
+					//seq_cst makes a load of the consumer's waiting flag after the claim never be reordered before it
+					if (m_enq.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					//the cell of the last lap has not been consumed yet
+					return false;
+				} else {
+					pos = m_enq.load(std::memory_order_relaxed);
+				}
+			}
+			::new ((void*)c->item()) _ItemT(std::forward<_ArgT>(item));
+			c->seq.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		template <class _ArgT>
+		void _overflow_push(_ArgT&& item) {
+			lock_guard<spin_mutex> lg(m_overflow_mtx);
+			m_overflow_q.push_back(std::forward<_ArgT>(item));
+			m_overflow.store(true, std::memory_order_seq_cst);
+		}
+
+		template <class _ArgT>
+		__NETP_FORCE_INLINE void _push(_ArgT&& item) {
+			if (!m_overflow.load(std::memory_order_acquire) && _ring_push(std::forward<_ArgT>(item))) {
+				return;
+			}
+			_overflow_push(std::forward<_ArgT>(item));
+		}
+
+		//consumer only, the published item at m_deq or nullptr, call _ring_release once it has been moved out
+		__NETP_FORCE_INLINE _ItemT* _ring_front() {
+			cell* c = m_cells + (m_deq & m_mask);
+			if (c->seq.load(std::memory_order_acquire) != (m_deq + 1)) {
+				return nullptr;
+			}
+			return c->item();
+		}
+
+		__NETP_FORCE_INLINE void _ring_release() {
+			cell* c = m_cells + (m_deq & m_mask);
+			c->item()->~_ItemT();
+			c->seq.store(m_deq + m_mask + 1, std::memory_order_release);
+			++m_deq;
+		}
+
+		//consumer only, the overflow is taken only if the ring is empty, its items were pushed after the ones of the ring
+		//the taken items are older than the ones pushed to the ring after the take, they are consumed first
+		bool _overflow_take() {
+			if (!m_overflow.load(std::memory_order_acquire) || m_enq.load(std::memory_order_acquire) != m_deq) {
+				return false;
+			}
+			lock_guard<spin_mutex> lg(m_overflow_mtx);
+			NETP_ASSERT(m_overflow_run.empty());
+			m_overflow_run.swap(m_overflow_q);
+			m_overflow.store(false, std::memory_order_relaxed);
+			return !m_overflow_run.empty();
+		}
+
+	public:
+		explicit mpsc_queue(netp::size_t capacity = NETP_MPSC_QUEUE_DEF_CAPACITY) :
+			m_overflow(false)
+		{
+			netp::size_t cap = 2;
+			while (cap < capacity) {
+				cap <<= 1;
+			}
+			m_cells = cell_allocator_t::make_array(cap);
+			NETP_ALLOC_CHECK(m_cells, sizeof(cell) * cap);
+			for (netp::size_t i = 0; i < cap; ++i) {
+				m_cells[i].seq.store(i, std::memory_order_relaxed);
+			}
+			m_mask = cap - 1;
+			m_enq.store(0, std::memory_order_relaxed);
+			m_deq = 0;
+		}
+
+		~mpsc_queue() {
+			_ItemT item;
+			while (pop(item)) {}
+			cell_allocator_t::trash_array(m_cells, m_mask + 1);
+		}
+
+		//thread safe
+		inline void push(_ItemT&& item) {
+			_push(std::move(item));
+		}
+
+		inline void push(_ItemT const& item) {
+			_push(item);
+		}
+
+		//consumer only
+		bool pop(_ItemT& item) {
+			if (m_overflow_run.empty()) {
+				_ItemT* front = _ring_front();
+				if (front != nullptr) {
+					item = std::move(*front);
+					_ring_release();
+					return true;
+				}
+				if (!_overflow_take()) {
+					return false;
+				}
+			}
+			item = std::move(m_overflow_run.front());
+			m_overflow_run.pop_front();
+			return true;
+		}
+
+		//consumer only, seq_cst loads to pair with the claim of _ring_push and the flag store of _overflow_push
+		//a claimed cell counts even if it is yet to be published
+		inline bool empty() const {
+			return m_enq.load(std::memory_order_seq_cst) == m_deq && !m_overflow.load(std::memory_order_seq_cst) && m_overflow_run.empty();
+		}
+
+		//consumer only, call fn in place for the items pushed before the call, the ones pushed by fn run at the next call
+		//one call consumes either the ring or the overflow, the overflow is consumed once the ring has been drained
+		//return the count of the items consumed
+		template <class _Fn>
+		netp::size_t consume(_Fn&& fn) {
+			netp::size_t n = 0;
+			if (!m_overflow_run.empty() || _overflow_take()) {
+				while (!m_overflow_run.empty()) {
+					fn(m_overflow_run.front());
+					m_overflow_run.pop_front();
+					++n;
+				}
+				return n;
+			}
+			const netp::size_t last = m_enq.load(std::memory_order_acquire);
+			while (m_deq != last) {
+				_ItemT* front = _ring_front();
+				if (front == nullptr) {
+					break;
+				}
+				fn(*front);
+				_ring_release();
+				++n;
+			}
+			return n;
+		}
+	};
+}
+#endif
@@ -2,6 +2,7 @@
 #define _NETP_POLLER_ABSTRACT_HPP
 
 #include <netp/core.hpp>
+#include <netp/funcs.hpp>
 #include <netp/io_monitor.hpp>
 
 #define NETP_DEBUG_IO_CTX_
@@ -11,9 +12,8 @@
 // 2, poll return with a timeout
 // 3, add a signal into the pipe/interrupt_fd before we reset inwait flag
 //in nano
-//ENTER HAS A lock_gurard to sure the compiler would not reorder it
-#define NETP_POLLER_WAIT_ENTER(W) ((W).store(true,std::memory_order_relaxed))
-#define NETP_POLLER_WAIT_EXIT(wt_in_nano,W) ((u64_t(wt_in_nano)>0)) ? (W).store(false,std::memory_order_release) : (void)0;
+//EXIT marks the end of the wait as well, the loop tells the wait from the io callbacks by it
+#define NETP_POLLER_WAIT_EXIT(wt_in_nano,W) do { ((u64_t(wt_in_nano)>0)) ? (W).store(false,std::memory_order_release) : (void)0; m_wait_exit_ns = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count(); } while(0)
 
 namespace netp {
 
@@ -22,6 +22,7 @@ namespace netp {
 		T_IOCP, //win
 		T_EPOLL, //linux,epoll,et
 		T_KQUEUE,//bsd
+		T_IO_URING, //linux,io_uring poll
 		T_POLLER_MAX,
 		T_NONE
 	};
@@ -31,7 +32,9 @@ namespace netp {
 		IO_WRITE = 1 << 1,
 		IO_READ_HUP = 1<<2, //read closed by remote peer
 		IO_ADD_PENDING = 1<<3, //USED BY SELECT ONLY,
-		IO_EPOLL_NOET = 1<<4 //USED BY EPOLL ONLY
+		IO_EPOLL_NOET = 1<<4, //USED BY EPOLL ONLY
+		IO_ERRQUEUE = 1<<5, //EPOLLERR goes to io_notify_errqueue first, USED BY EPOLL ONLY
+		IO_EPOLL_WRITE_BLOCKED = 1<<6 //set by a write that got EAGAIN right before it watches write, the writable edge is still ahead, USED BY EPOLL ONLY
 	};
 
 	enum class io_action {
@@ -50,6 +53,7 @@ namespace netp {
 	{
 		SOCKET fd;
 		u8_t flag;
+		u8_t ep_flag; //interest set armed in kernel, USED BY EPOLL ONLY
 		NRP<io_monitor> iom;
 		io_ctx* prev, *next;
 	};
@@ -59,6 +63,7 @@ namespace netp {
 		if (ctx != 0) {
 			ctx->fd = fd;
 			ctx->flag = 0;
+			ctx->ep_flag = 0;
 			ctx->iom = iom;
 		}
 		return ctx;
@@ -75,14 +80,22 @@ namespace netp {
 	{
 	protected:
 		io_poller_type m_type;
+		i64_t m_wait_exit_ns; //steady clock, set by NETP_POLLER_WAIT_EXIT
 	public:
-		poller_abstract(io_poller_type t):m_type(t) {}
+		poller_abstract(io_poller_type t):m_type(t),m_wait_exit_ns(0) {}
 		~poller_abstract() {}
 
 		virtual void init() = 0;
 		virtual void deinit() = 0;
 
-		virtual void poll(i64_t wait_in_nano, std::atomic<bool>& waiting) = 0;
+		//return the count of the ready events it got, 0 for timeout|error
+		virtual int poll(i64_t wait_in_nano, std::atomic<bool>& waiting) = 0;
+
+		//interest changes issued to the kernel, written by the loop thread only
+		virtual u64_t ctl_count() const { return 0; }
+
+		//the steady clock in nano when the wait of the last poll returned, loop thread only
+		inline i64_t wait_exit_ns() const { return m_wait_exit_ns; }
 
 		virtual void interrupt_wait() = 0;
 		virtual int io_do(io_action, io_ctx*) = 0;
@@ -2,8 +2,10 @@
 #define _NETP_EPOLL_POLLER_HPP_
 
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
 #include <syscall.h>
 #include <poll.h>
+#include <time.h>
 
 #include <netp/core.hpp>
 #include <netp/poller_interruptable_by_fd.hpp>
@@ -15,18 +17,73 @@
 
 namespace netp {
 
-	const static int _s_flag_epollin_epollout_map[2] = {
-		EPOLLIN,EPOLLOUT
+	enum epoll_ctx_flag {
+		EP_ARMED_IN = io_flag::IO_READ,
+		EP_ARMED_OUT = io_flag::IO_WRITE,
+		EP_CTL_PENDING = 1<<2, //in m_ctl_pending
+		EP_CTL_REARM = 1<<3 //MOD even if the interest set is not changed
 	};
 
+	typedef std::vector<io_ctx*, netp::allocator<io_ctx*>> epoll_ctl_pending_t;
+
+	//epoll_wait takes the timeout in milli, we wait for the timer in nano by
+	//1) epoll_pwait2 (linux 5.11), or
+	//2) a timerfd armed to the deadline, epoll_wait only works as a backstop
 	class poller_epoll final:
 		public poller_interruptable_by_fd
 	{
 		int m_epfd;
+		int m_tfd;
+		bool m_pwait2;
+		i64_t m_tfd_deadline; //CLOCK_MONOTONIC in nano, 0 means not armed
+		epoll_ctl_pending_t m_ctl_pending;
+		epoll_ctl_pending_t m_ctl_flushing;
+		std::atomic<u64_t> m_ctl_count;
+
+		int __epoll_pwait2(struct epoll_event* evts, int maxevts, i64_t wait_in_nano) {
+#ifdef __NR_epoll_pwait2
+			struct timespec ts = { time_t(wait_in_nano / i64_t(1000000000)), long(wait_in_nano % i64_t(1000000000)) };
+			return int(::syscall(__NR_epoll_pwait2, m_epfd, evts, maxevts, &ts, 0, 0));
+#else
+			(void)evts; (void)maxevts; (void)wait_in_nano;
+			return -1;
+#endif
+		}
+
+		void __tfd_arm(i64_t wait_in_nano) {
+			struct timespec now;
+			::clock_gettime(CLOCK_MONOTONIC, &now);
+			const i64_t deadline = i64_t(now.tv_sec) * i64_t(1000000000) + now.tv_nsec + wait_in_nano;
+			const i64_t diff = deadline - m_tfd_deadline;
+			if ((m_tfd_deadline != 0) && (diff < NETP_EPOLL_TIMERFD_SLACK) && (diff > -NETP_EPOLL_TIMERFD_SLACK)) {
+				return;
+			}
+			struct itimerspec its = { {0,0}, { time_t(deadline / i64_t(1000000000)), long(deadline % i64_t(1000000000)) } };
+			if (::timerfd_settime(m_tfd, TFD_TIMER_ABSTIME, &its, 0) == -1) {
+				NETP_ERR("[EPOLL][##%u]timerfd_settime failed!, errno: %d", m_epfd, netp_socket_get_last_errno());
+				m_tfd_deadline = 0;
+				return;
+			}
+			m_tfd_deadline = deadline;
+		}
+
+		//a deadline left by an early return would wake up a later wait for nothing
+		void __tfd_disarm() {
+			struct itimerspec its = { {0,0}, {0,0} };
+			if (::timerfd_settime(m_tfd, 0, &its, 0) == -1) {
+				NETP_ERR("[EPOLL][##%u]timerfd_settime disarm failed!, errno: %d", m_epfd, netp_socket_get_last_errno());
+			}
+			m_tfd_deadline = 0;
+		}
+
 	public:
 		poller_epoll():
 			poller_interruptable_by_fd(io_poller_type::T_EPOLL),
-			m_epfd(NETP_INVALID_SOCKET)
+			m_epfd(NETP_INVALID_SOCKET),
+			m_tfd(NETP_INVALID_SOCKET),
+			m_pwait2(false),
+			m_tfd_deadline(0),
+			m_ctl_count(0)
 		{
 		}
 
@@ -34,6 +91,59 @@ namespace netp {
 			NETP_ASSERT( m_epfd == NETP_INVALID_SOCKET);
 		}
 
+		__NETP_FORCE_INLINE
+		static u32_t __epoll_events(io_ctx* ctx, u8_t armed) {
+			u32_t events = (ctx->flag&io_flag::IO_EPOLL_NOET) ? (EPOLLRDHUP|EPOLLHUP|EPOLLERR) : (EPOLLET|EPOLLRDHUP|EPOLLHUP|EPOLLERR);
+			if (armed&EP_ARMED_IN) { events |= EPOLLIN; }
+			if (armed&EP_ARMED_OUT) { events |= EPOLLOUT; }
+			return events;
+		}
+
+		int __ctl(int epoll_op, io_ctx* ctx, u8_t armed) {
+			struct epoll_event epEvent = { __epoll_events(ctx, armed), {(void*)ctx} };
+			m_ctl_count.store(m_ctl_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			NETP_TRACE_IOE("[EPOLL][##%u][ctl][#%u]op: %d, evts: %u", m_epfd, ctx->fd, epoll_op, epEvent.events);
+			return epoll_ctl(m_epfd, epoll_op, ctx->fd, &epEvent);
+		}
+
+		void __ctl_defer(io_ctx* ctx, u8_t f) {
+			if ((ctx->ep_flag&EP_CTL_PENDING) == 0) {
+				m_ctl_pending.push_back(ctx);
+			}
+			ctx->ep_flag |= (EP_CTL_PENDING|f);
+		}
+
+		//one MOD per fd for the net change since the last poll
+		void __ctl_flush() {
+			m_ctl_flushing.swap(m_ctl_pending);
+			for (io_ctx* ctx : m_ctl_flushing) {
+				const u8_t rearm = (ctx->ep_flag&EP_CTL_REARM);
+				ctx->ep_flag &= ~(EP_CTL_PENDING|EP_CTL_REARM);
+				const u8_t armed = (ctx->ep_flag&(EP_ARMED_IN|EP_ARMED_OUT));
+				u8_t target = (ctx->flag&(io_flag::IO_READ|io_flag::IO_WRITE));
+				if ((armed == 0) || (target == 0)) {
+					//removed by EPOLL_CTL_DEL already
+					continue;
+				}
+				if (!(ctx->flag&io_flag::IO_EPOLL_NOET)) {
+					target |= (armed&EP_ARMED_OUT);
+				}
+				if ((target == armed) && !rearm) {
+					continue;
+				}
+				if (__ctl(EPOLL_CTL_MOD, ctx, target) == -1) {
+					const int ec = netp_socket_get_last_errno();
+					NETP_ERR("[EPOLL][##%u][#%u]deferred EPOLL_CTL_MOD failed: %d", m_epfd, ctx->fd, ec);
+					(ctx->flag&io_flag::IO_READ) ? ctx->iom->io_notify_read(ec, ctx) : ctx->iom->io_notify_write(ec, ctx);
+					continue;
+				}
+				ctx->ep_flag = u8_t((ctx->ep_flag&~(EP_ARMED_IN|EP_ARMED_OUT)) | target);
+			}
+			m_ctl_flushing.clear();
+		}
+
+		//@note: ADD|DEL go to kernel at once, the caller needs the error of ADD, and the fd might be closed right after DEL
+		//MODs are deferred to the next poll, a read|write interest toggled in one loop iteration costs nothing
 		int watch(u8_t flag, io_ctx* ctx) override {
 
 #ifdef _NETP_DEBUG_EPOLL_EVENTS
@@ -42,58 +152,71 @@ namespace netp {
 			//test forcce lt
 			//ctx->flag |= io_flag::IO_EPOLL_NOET;
 #endif
-
-			struct epoll_event epEvent =
-			{
-				(ctx->flag&io_flag::IO_EPOLL_NOET) ? (EPOLLRDHUP|EPOLLHUP|EPOLLERR) : (EPOLLET|EPOLLRDHUP|EPOLLHUP|EPOLLERR),
-				{(void*)ctx}
-			};
-
-			int epoll_op = EPOLL_CTL_ADD;
+			const bool write_blocked = (ctx->flag&io_flag::IO_EPOLL_WRITE_BLOCKED) != 0;
+			ctx->flag &= ~io_flag::IO_EPOLL_WRITE_BLOCKED;
 			if ( (ctx->flag&flag) == flag ) {
 				return netp::OK;
-			} else if ( ctx->flag&(io_flag::IO_READ|io_flag::IO_WRITE) ) {
-				epoll_op = EPOLL_CTL_MOD;
-				epEvent.events |= (EPOLLIN|EPOLLOUT);
-			} else {
-				epEvent.events |= _s_flag_epollin_epollout_map[--flag];
 			}
 
-#ifdef _NETP_DEBUG_EPOLL_EVENTS
-			NETP_ASSERT(epEvent.events & (EPOLLIN|EPOLLOUT) );
-#endif
-			NETP_TRACE_IOE("[EPOLL][##%u][watch][#%u]op: %c, evts: %u", m_epfd, ctx->fd, epoll_op == EPOLL_CTL_MOD ? 'm' : 'a', epEvent.events);
-			return epoll_ctl(m_epfd, epoll_op, ctx->fd, &epEvent);
+			const u8_t armed = (ctx->ep_flag&(EP_ARMED_IN|EP_ARMED_OUT));
+			if (armed == 0) {
+				NETP_TRACE_IOE("[EPOLL][##%u][watch][#%u]op: a, flag: %u", m_epfd, ctx->fd, flag);
+				int rt = __ctl(EPOLL_CTL_ADD, ctx, flag);
+				if (rt == 0) {
+					ctx->ep_flag |= flag;
+				}
+				return rt;
+			}
+
+			if (armed&flag) {
+				//an ET edge that came while it was not watched is gone, MOD re-evaluates the readiness
+				//but a write that got EAGAIN just now has its writable edge ahead
+				if ((flag == io_flag::IO_WRITE) && write_blocked && !(ctx->flag&io_flag::IO_EPOLL_NOET)) {
+					return netp::OK;
+				}
+				__ctl_defer(ctx, EP_CTL_REARM);
+				return netp::OK;
+			}
+			__ctl_defer(ctx, 0);
+			return netp::OK;
 		}
 
 		int unwatch( u8_t flag, io_ctx* ctx ) override {
 #ifdef _NETP_DEBUG_EPOLL_EVENTS
 			NETP_ASSERT((ctx->fd != NETP_INVALID_SOCKET) && (flag == io_flag::IO_READ || flag == io_flag::IO_WRITE));
 #endif
-			struct epoll_event epEvent =
-			{
-				(ctx->flag&io_flag::IO_EPOLL_NOET) ? (EPOLLRDHUP|EPOLLHUP|EPOLLERR) : (EPOLLET|EPOLLRDHUP|EPOLLHUP|EPOLLERR),
-				{(void*)ctx}
-			};
+			ctx->flag &= ~io_flag::IO_EPOLL_WRITE_BLOCKED;
+			if ((ctx->ep_flag&(EP_ARMED_IN|EP_ARMED_OUT)) == 0) {
+				return netp::OK;
+			}
 
-			int epoll_op = EPOLL_CTL_MOD;
 			u8_t remaining_flag = ((ctx->flag&(~flag)) & (io_flag::IO_READ|io_flag::IO_WRITE));
-			if (remaining_flag) {
-				epEvent.events |= _s_flag_epollin_epollout_map[--remaining_flag];
-			} else {
+			if (remaining_flag == 0) {
 				//@note
 				//In kernel versions before 2.6.9, the EPOLL_CTL_DEL operation required a non - NULL pointer in event, even though this argument is ignored.
 				//Since Linux 2.6.9, event can be specified as NULL when using EPOLL_CTL_DEL.Applications that need to be portable to kernels before 2.6.9 should specify a non - NULL pointer in event.
+				NETP_TRACE_IOE("[EPOLL][##%u][unwatch][#%u]op: d", m_epfd, ctx->fd);
+				ctx->ep_flag &= ~(EP_ARMED_IN|EP_ARMED_OUT);
+				return __ctl(EPOLL_CTL_DEL, ctx, 0);
+			}
 
-				//epEvent.events &= ~(EPOLLIN|EPOLLOUT);
-				epoll_op = EPOLL_CTL_DEL;
+			//ET: keep EPOLLOUT armed, the edges are dropped by the flag check of poll, and the next watch after a EAGAIN needs no MOD
+			if ((flag == io_flag::IO_WRITE) && !(ctx->flag&io_flag::IO_EPOLL_NOET)) {
+				return netp::OK;
 			}
+			__ctl_defer(ctx, 0);
+			return netp::OK;
+		}
 
-#ifdef _NETP_DEBUG_EPOLL_EVENTS
-			NETP_ASSERT(epoll_op == EPOLL_CTL_MOD ? (epEvent.events & (EPOLLIN|EPOLLOUT)) && (ctx->flag&(io_flag::IO_READ | io_flag::IO_WRITE)) : true);
-#endif
-			NETP_TRACE_IOE("[EPOLL][##%u][unwatch][#%u]op: %c, evts: %u", m_epfd, ctx->fd, epoll_op, epoll_op == EPOLL_CTL_MOD ? 'm': 'd', epEvent.events);
-			return epoll_ctl(m_epfd,epoll_op,ctx->fd,&epEvent) ;
+		void io_end(io_ctx* ctx) override {
+			if (ctx->ep_flag&EP_CTL_PENDING) {
+				m_ctl_pending.erase(std::find(m_ctl_pending.begin(), m_ctl_pending.end(), ctx));
+			}
+			poller_interruptable_by_fd::io_end(ctx);
+		}
+
+		u64_t ctl_count() const override {
+			return m_ctl_count.load(std::memory_order_relaxed);
 		}
 
 	public:
@@ -104,11 +227,35 @@ namespace netp {
 				NETP_THROW("create epoll handle failed");
 			}
 			NETP_VERBOSE("[EPOLL][##%u]init epoll handle ok", m_epfd);
+
+			//nothing is watched yet, a zero wait returns at once if the kernel has it
+			struct epoll_event probe;
+			m_pwait2 = (__epoll_pwait2(&probe, 1, 0) != -1);
+			if (!m_pwait2) {
+				m_tfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC);
+				if (m_tfd == -1) {
+					NETP_WARN("[EPOLL][##%u]timerfd_create failed: %d, fallback to milli wait", m_epfd, netp_socket_get_last_errno());
+					m_tfd = NETP_INVALID_SOCKET;
+				} else {
+					//@note: data.ptr == 0 tells the timerfd, ET is enough as every expiration wakes up the waitqueue
+					struct epoll_event epEvent = { EPOLLIN|EPOLLET, {(void*)0} };
+					if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_tfd, &epEvent) == -1) {
+						NETP_WARN("[EPOLL][##%u]watch timerfd failed: %d, fallback to milli wait", m_epfd, netp_socket_get_last_errno());
+						netp::close(m_tfd);
+						m_tfd = NETP_INVALID_SOCKET;
+					}
+				}
+			}
 			poller_interruptable_by_fd::init();
 		}
 
 		void deinit() override {
 			poller_interruptable_by_fd::deinit();
+			if (m_tfd != NETP_INVALID_SOCKET) {
+				netp::close(m_tfd);
+				m_tfd = NETP_INVALID_SOCKET;
+				m_tfd_deadline = 0;
+			}
 			NETP_ASSERT(m_epfd != NETP_INVALID_SOCKET);
 			NETP_VERBOSE("[EPOLL][##%u]EPOLL::deinit() begin", m_epfd);
 			int rt = netp::close(m_epfd);
@@ -119,16 +266,33 @@ namespace netp {
 			m_epfd = NETP_INVALID_SOCKET;
 		}
 
-		void poll(i64_t wait_in_nano, std::atomic<bool>& W) override {
+		int poll(i64_t wait_in_nano, std::atomic<bool>& W) override {
 			NETP_ASSERT(m_epfd != NETP_INVALID_SOCKET);
+			if (m_ctl_pending.size()) {
+				__ctl_flush();
+			}
 
 			struct epoll_event epEvents[NETP_EPOLL_PER_HANDLE_SIZE];
-			const int wait_in_mill = (wait_in_nano != ~0 ? (wait_in_nano / i64_t(1000000)) : ~0);
-			int nEvents = epoll_wait(m_epfd, epEvents, NETP_EPOLL_PER_HANDLE_SIZE, wait_in_mill);
+			int nEvents;
+			if ((wait_in_nano <= 0) || ((wait_in_nano % i64_t(1000000)) == 0)) {
+				//0, ~0, or exact milli
+				if (m_tfd_deadline != 0) {
+					__tfd_disarm();
+				}
+				nEvents = epoll_wait(m_epfd, epEvents, NETP_EPOLL_PER_HANDLE_SIZE, (wait_in_nano != ~0 ? int(wait_in_nano / i64_t(1000000)) : ~0));
+			} else if (m_pwait2) {
+				nEvents = __epoll_pwait2(epEvents, NETP_EPOLL_PER_HANDLE_SIZE, wait_in_nano);
+			} else {
+				//round up, an early return only ends in a zero wait spin till the deadline
+				if (m_tfd != NETP_INVALID_SOCKET) {
+					__tfd_arm(wait_in_nano);
+				}
+				nEvents = epoll_wait(m_epfd, epEvents, NETP_EPOLL_PER_HANDLE_SIZE, int(wait_in_nano / i64_t(1000000)) + 1);
+			}
 			NETP_POLLER_WAIT_EXIT(wait_in_nano, W);
 			if (-1 == nEvents) {
 				NETP_ERR("[EPOLL][##%u]epoll wait event failed!, errno: %d", m_epfd, netp_socket_get_last_errno());
-				return;
+				return 0;
 			}
 
 #ifdef _NETP_DEBUG_EPOLL_EVENTS
@@ -137,22 +301,32 @@ namespace netp {
 			//remove poll_wait queue
 			//remove rdlink from list
 			for (int i = 0; i < nEvents; ++i) {
-				NETP_ASSERT(epEvents[i].data.ptr != nullptr);
+				if (epEvents[i].data.ptr == nullptr) { continue; }
 				io_ctx* ctx = (static_cast<io_ctx*> (epEvents[i].data.ptr));
 				NETP_ASSERT((ctx->fd != NETP_INVALID_SOCKET) && (ctx->flag&(io_flag::IO_READ|io_flag::IO_WRITE)), "fd: %u, flag: %u, event: %u", ctx->fd, ctx->flag, epEvents[i].events);
 			}
 #endif
 
 			//@note: if fda's event might result in unwatch(R|W) for fdb
+			int nready = nEvents;
 			for( int i=0;i<nEvents;++i) {
-#ifdef _NETP_DEBUG_EPOLL_EVENTS
-				NETP_ASSERT( epEvents[i].data.ptr != nullptr );
-#endif
+				if (NETP_UNLIKELY(epEvents[i].data.ptr == nullptr)) {
+					//the timerfd expired, no read needed, the rearm resets the ticks
+					m_tfd_deadline = 0;
+					--nready;
+					continue;
+				}
 				uint32_t events = ((epEvents[i].events) & 0xFFFFFFFF);
 				io_ctx* ctx = (static_cast<io_ctx*> (epEvents[i].data.ptr));
 #ifdef _NETP_DEBUG_EPOLL_EVENTS
 				NETP_ASSERT((ctx->fd != NETP_INVALID_SOCKET) && (ctx->flag&(io_flag::IO_READ|io_flag::IO_WRITE)), "fd: %u, flag: %u, event: %u", ctx->fd, ctx->flag, events);
 #endif
+				NRP<io_monitor>& iom = ctx->iom;
+				//a MSG_ZEROCOPY completion raise EPOLLERR without any pending SO_ERROR, drain it before we check the socket error
+				if ((events&EPOLLERR) && (ctx->flag&io_flag::IO_ERRQUEUE)) {
+					iom->io_notify_errqueue(netp::OK, ctx);
+				}
+
 				int sockerr = netp::OK;
 				//refer to:https://elixir.bootlin.com/linux/v4.19/source/net/ipv4/tcp.c#L524
 				//EPOLLHUP is only sent when the shutdown has been both for read and write (I reckon that the peer shutdowning the write equals to my shutdowning the read). Or when the connection is closed, of course.
@@ -169,6 +343,10 @@ namespace netp {
 						}
 					}
 					else { sockerr=NETP_NEGATIVE(sockerr); }
+
+					if ((sockerr == netp::OK) && (ctx->flag&io_flag::IO_ERRQUEUE) && !(events&EPOLLHUP)) {
+						events &= ~EPOLLERR;
+					}
 				}
 
 				//NETP_TRACE_IOE( "[EPOLL][##%u][#%d]EVT: events(%d)", m_epfd, ctx->fd, events );
@@ -181,7 +359,6 @@ namespace netp {
 				// 4) EPOLLRDHUP|EPOLLIN would arrive at the same time (but it's not sometimes), keep reading until read() return 0 to avoid a miss
 				//		4.1) alternative solution is to ignore read if we get EPOLLRDHUB, in this case, we might miss some pending data in rcvbuf 
 
-				NRP<io_monitor>& iom = ctx->iom;
 				//do not check EPOLLERR|EPOLLHUP for read/write, as we has checked before, if they are set, sockerr must not be netp::OK
 				if ((ctx->flag&u8_t(io_flag::IO_READ)) && (events&(EPOLLIN|EPOLLRDHUP|EPOLLERR|EPOLLHUP)) ) {
 					if (events&EPOLLRDHUP) {
@@ -195,6 +372,7 @@ namespace netp {
 					iom->io_notify_write(sockerr, ctx);
 				}
 			}
+			return nready;
 		}
 	};
 }
@@ -0,0 +1,525 @@
+#ifndef _NETP_POLLER_IO_URING_HPP_
+#define _NETP_POLLER_IO_URING_HPP_
+
+#include <sys/mman.h>
+#include <syscall.h>
+#include <poll.h>
+#include <linux/io_uring.h>
+
+#include <netp/core.hpp>
+#include <netp/poller_interruptable_by_fd.hpp>
+#include <netp/socket_api.hpp>
+
+//@note: readiness by IORING_OP_POLL_ADD (oneshot, level triggered), a watch/rearm is a sqe, all sqes queued in one loop iteration are submitted by the io_uring_enter that waits for the next completions
+//the socket io itself stays on the syscalls of socket_channel
+
+namespace netp {
+
+	//the armed bits are the polls in flight, the ctx is freed on the completion of the last one
+	struct io_uring_ctx final :
+		public io_ctx
+	{
+		u8_t armed;
+		bool ended;
+	};
+
+	enum io_uring_armed_flag {
+		IO_URING_ARMED_READ = io_flag::IO_READ,
+		IO_URING_ARMED_WRITE = io_flag::IO_WRITE,
+		IO_URING_DISPATCHING = 1 << 2 //no free in the iom callback
+	};
+
+	class poller_io_uring final :
+		public poller_interruptable_by_fd
+	{
+		int m_ringfd;
+		u32_t m_features;
+
+		void* m_sq_ptr;
+		size_t m_sq_sz;
+		void* m_cq_ptr;
+		size_t m_cq_sz;
+		struct io_uring_sqe* m_sqes;
+		size_t m_sqes_sz;
+
+		u32_t* m_sq_khead;
+		u32_t* m_sq_ktail;
+		u32_t* m_sq_kflags;
+		u32_t m_sq_mask;
+		u32_t m_sq_entries;
+		u32_t m_sq_tail;
+
+		u32_t* m_cq_khead;
+		u32_t* m_cq_ktail;
+		u32_t m_cq_mask;
+		struct io_uring_cqe* m_cqes;
+
+		//the ended ones waiting for the completion of the polls in flight
+		long m_ctx_pending_free;
+		struct __kernel_timespec m_ts;
+
+		inline int __enter(u32_t to_submit, u32_t min_complete, u32_t flags, void* arg, size_t argsz) {
+			return int(::syscall(__NR_io_uring_enter, m_ringfd, to_submit, min_complete, flags, arg, argsz));
+		}
+
+		inline u32_t __to_submit() const {
+			return m_sq_tail - __atomic_load_n(m_sq_khead, __ATOMIC_ACQUIRE);
+		}
+
+		int __submit() {
+			__atomic_store_n(m_sq_ktail, m_sq_tail, __ATOMIC_RELEASE);
+			const u32_t to_submit = __to_submit();
+			if (to_submit == 0) {
+				return netp::OK;
+			}
+			int rt = __enter(to_submit, 0, 0, 0, 0);
+			if (rt == -1) {
+				rt = netp_socket_get_last_errno();
+				NETP_WARN("[IO_URING][##%u]submit failed: %d", m_ringfd, rt);
+				return rt;
+			}
+			return netp::OK;
+		}
+
+		struct io_uring_sqe* __sqe_get() {
+			if ((m_sq_tail - __atomic_load_n(m_sq_khead, __ATOMIC_ACQUIRE)) == m_sq_entries) {
+				//flush the queued ones, the kernel consumes all of them at submit
+				__submit();
+				if ((m_sq_tail - __atomic_load_n(m_sq_khead, __ATOMIC_ACQUIRE)) == m_sq_entries) {
+					return 0;
+				}
+			}
+			struct io_uring_sqe* sqe = &m_sqes[m_sq_tail & m_sq_mask];
+			++m_sq_tail;
+			std::memset(sqe, 0, sizeof(struct io_uring_sqe));
+			return sqe;
+		}
+
+		int __poll_add(io_uring_ctx* uctx, u8_t flag) {
+			struct io_uring_sqe* sqe = __sqe_get();
+			if (sqe == 0) {
+				return netp::E_ENOBUFS;
+			}
+			u32_t events = (flag == io_flag::IO_READ) ? (POLLIN | POLLRDHUP) : POLLOUT;
+#if __NETP_IS_BIG_ENDIAN
+			events = (events << 16) | (events >> 16);
+#endif
+			sqe->opcode = IORING_OP_POLL_ADD;
+			sqe->fd = uctx->fd;
+			sqe->poll32_events = events;
+			sqe->user_data = u64_t(uctx) | flag;
+			uctx->armed |= flag;
+			return netp::OK;
+		}
+
+		int __poll_remove(io_uring_ctx* uctx, u8_t flag) {
+			struct io_uring_sqe* sqe = __sqe_get();
+			if (sqe == 0) {
+				return netp::E_ENOBUFS;
+			}
+			sqe->opcode = IORING_OP_POLL_REMOVE;
+			sqe->fd = -1;
+			sqe->addr = u64_t(uctx) | flag;
+			sqe->user_data = 0;
+			return netp::OK;
+		}
+
+		inline void __ctx_free(io_uring_ctx* uctx) {
+			uctx->iom = nullptr;
+			netp::allocator<io_uring_ctx>::trash(uctx);
+		}
+
+		void __dispatch(io_uring_ctx* uctx, u8_t flag, int res) {
+			io_ctx* ctx = uctx;
+			NRP<io_monitor>& iom = ctx->iom;
+			if (res < 0) {
+				//-ECANCELED: ring teardown, just drop it
+				if ((res != netp::E_ECANCELED) && (ctx->flag & flag)) {
+					(flag == io_flag::IO_READ) ? iom->io_notify_read(res, ctx) : iom->io_notify_write(res, ctx);
+				}
+				return;
+			}
+
+			u32_t events = u32_t(res);
+			if ((events & POLLERR) && (ctx->flag & io_flag::IO_ERRQUEUE)) {
+				iom->io_notify_errqueue(netp::OK, ctx);
+			}
+
+			int sockerr = netp::OK;
+			if (events & (POLLERR | POLLHUP)) {
+				socklen_t optlen = sizeof(int);
+				int readsockfderr = ::getsockopt(ctx->fd, SOL_SOCKET, SO_ERROR, (char*)&sockerr, &optlen);
+				(void)readsockfderr;
+				if (sockerr == -1) {
+					sockerr = (events & POLLHUP) ? netp::E_SOCKET_EPOLLHUP : netp::E_UNKNOWN;
+				} else {
+					sockerr = NETP_NEGATIVE(sockerr);
+				}
+				if ((sockerr == netp::OK) && (ctx->flag & io_flag::IO_ERRQUEUE) && !(events & POLLHUP)) {
+					events &= ~POLLERR;
+				}
+			}
+
+			if (flag == io_flag::IO_READ) {
+				if ((ctx->flag & io_flag::IO_READ) && (events & (POLLIN | POLLRDHUP | POLLERR | POLLHUP))) {
+					if (events & POLLRDHUP) {
+						ctx->flag |= io_flag::IO_READ_HUP;
+					}
+					iom->io_notify_read(sockerr, ctx);
+				}
+			} else if ((ctx->flag & io_flag::IO_WRITE) && (events & (POLLOUT | POLLERR | POLLHUP))) {
+				iom->io_notify_write(sockerr, ctx);
+			}
+		}
+
+		//process the completions in the cq ring, return the count
+		int __reap_cq() {
+			u32_t head = *m_cq_khead;
+			const u32_t tail = __atomic_load_n(m_cq_ktail, __ATOMIC_ACQUIRE);
+			int n = 0;
+			while (head != tail) {
+				struct io_uring_cqe* cqe = &m_cqes[head & m_cq_mask];
+				const u64_t ud = cqe->user_data;
+				const int res = cqe->res;
+				__atomic_store_n(m_cq_khead, ++head, __ATOMIC_RELEASE);
+				++n;
+				if (ud == 0) {
+					continue; //poll remove, timeout
+				}
+
+				io_uring_ctx* uctx = (io_uring_ctx*)(ud & ~u64_t(IO_URING_ARMED_READ | IO_URING_ARMED_WRITE));
+				const u8_t flag = u8_t(ud & (IO_URING_ARMED_READ | IO_URING_ARMED_WRITE));
+				uctx->armed &= ~flag;
+				if (uctx->ended) {
+					if (uctx->armed == 0) {
+						__ctx_free(uctx);
+						--m_ctx_pending_free;
+					}
+					continue;
+				}
+
+				uctx->armed |= IO_URING_DISPATCHING;
+				__dispatch(uctx, flag, res);
+				uctx->armed &= ~IO_URING_DISPATCHING;
+				if (uctx->ended) {
+					if (uctx->armed == 0) {
+						__ctx_free(uctx);
+						--m_ctx_pending_free;
+					}
+					continue;
+				}
+
+				//oneshot, rearm if it's still watched
+				if ((uctx->flag & flag) && !(uctx->armed & flag)) {
+					int rt = __poll_add(uctx, flag);
+					if (rt != netp::OK) {
+						NETP_ERR("[IO_URING][##%u][#%u]rearm failed: %d", m_ringfd, uctx->fd, rt);
+						(flag == io_flag::IO_READ) ? uctx->iom->io_notify_read(rt, uctx) : uctx->iom->io_notify_write(rt, uctx);
+					}
+				}
+			}
+			return n;
+		}
+
+		//@note: the completions that did not fit in the cq ring are held by the kernel (IORING_FEAT_NODROP) till a getevents enter moves them in
+		//they might be missed for good without this check, as the wait does not return for them
+		int __reap() {
+			int n = __reap_cq();
+			while (__atomic_load_n(m_sq_kflags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) {
+				const int rt = __enter(0, 0, IORING_ENTER_GETEVENTS, 0, 0);
+				if ((rt == -1) && (netp_socket_get_last_errno() != netp::E_EINTR) && (netp_socket_get_last_errno() != netp::E_EBUSY)) {
+					NETP_ERR("[IO_URING][##%u]flush cq overflow failed: %d", m_ringfd, netp_socket_get_last_errno());
+					break;
+				}
+				const int m = __reap_cq();
+				if (m == 0) {
+					break;
+				}
+				n += m;
+			}
+			return n;
+		}
+
+		void __unmap() {
+			if (m_sqes != 0) {
+				::munmap(m_sqes, m_sqes_sz);
+				m_sqes = 0;
+			}
+			if ((m_cq_ptr != 0) && (m_cq_ptr != m_sq_ptr)) {
+				::munmap(m_cq_ptr, m_cq_sz);
+			}
+			m_cq_ptr = 0;
+			if (m_sq_ptr != 0) {
+				::munmap(m_sq_ptr, m_sq_sz);
+				m_sq_ptr = 0;
+			}
+		}
+
+	public:
+		poller_io_uring() :
+			poller_interruptable_by_fd(io_poller_type::T_IO_URING),
+			m_ringfd(NETP_INVALID_SOCKET),
+			m_features(0),
+			m_sq_ptr(0),
+			m_sq_sz(0),
+			m_cq_ptr(0),
+			m_cq_sz(0),
+			m_sqes(0),
+			m_sqes_sz(0),
+			m_sq_tail(0),
+			m_ctx_pending_free(0)
+		{}
+
+		~poller_io_uring() {
+			//set up by the maker, but the loop never ran
+			if (m_ringfd != NETP_INVALID_SOCKET) {
+				__unmap();
+				netp::close(m_ringfd);
+				m_ringfd = NETP_INVALID_SOCKET;
+			}
+		}
+
+		int watch(u8_t flag, io_ctx* ctx) override {
+#ifdef _NETP_DEBUG
+			NETP_ASSERT((ctx->fd != NETP_INVALID_SOCKET) && (flag == io_flag::IO_READ || flag == io_flag::IO_WRITE));
+			NETP_ASSERT((flag & ctx->flag) == 0);
+#endif
+			io_uring_ctx* uctx = static_cast<io_uring_ctx*>(ctx);
+			if (uctx->armed & flag) {
+				//a lazy unwatch left it in flight
+				return netp::OK;
+			}
+			return __poll_add(uctx, flag);
+		}
+
+		//@note: the poll in flight is left as it is, it would be dropped on completion, most of them are write polls which complete soon
+		int unwatch(u8_t flag, io_ctx* ctx) override {
+#ifdef _NETP_DEBUG
+			NETP_ASSERT((ctx->fd != NETP_INVALID_SOCKET) && (flag == io_flag::IO_READ || flag == io_flag::IO_WRITE));
+#endif
+			(void)flag;
+			(void)ctx;
+			return netp::OK;
+		}
+
+		io_ctx* io_begin(SOCKET fd, NRP<io_monitor> const& iom) override {
+			io_uring_ctx* uctx = netp::allocator<io_uring_ctx>::make();
+			if (uctx == 0) {
+				return 0;
+			}
+			NETP_ASSERT((u64_t(uctx) & u64_t(IO_URING_ARMED_READ | IO_URING_ARMED_WRITE)) == 0);
+			uctx->fd = fd;
+			uctx->flag = 0;
+			uctx->iom = iom;
+			uctx->armed = 0;
+			uctx->ended = false;
+			netp::list_append(&m_io_ctx_list, static_cast<io_ctx*>(uctx));
+
+#ifdef NETP_DEBUG_IO_CTX_
+			++m_io_ctx_count_alloc;
+#endif
+			NETP_TRACE_IOE("[IO_URING][io_begin][#%d]", fd);
+			return uctx;
+		}
+
+		void io_end(io_ctx* ctx) override {
+			NETP_TRACE_IOE("[IO_URING][io_end][#%d]", ctx->fd);
+			NETP_ASSERT((ctx->iom != nullptr) && ((ctx->flag & (io_flag::IO_READ | io_flag::IO_WRITE)) == 0), "flag: %u", ctx->flag);
+			netp::list_delete(ctx);
+#ifdef NETP_DEBUG_IO_CTX_
+			++m_io_ctx_count_free;
+#endif
+
+			io_uring_ctx* uctx = static_cast<io_uring_ctx*>(ctx);
+			uctx->ended = true;
+			if (uctx->armed == 0) {
+				__ctx_free(uctx);
+				return;
+			}
+
+			++m_ctx_pending_free;
+			if (uctx->armed & IO_URING_ARMED_READ) {
+				__poll_remove(uctx, io_flag::IO_READ);
+			}
+			if (uctx->armed & IO_URING_ARMED_WRITE) {
+				__poll_remove(uctx, io_flag::IO_WRITE);
+			}
+		}
+
+		//create and map the ring, return non-zero if the kernel does not have io_uring, or it is disabled (io_uring_disabled, seccomp)
+		//called by the loop maker, it falls back to the default poller on failure
+		int setup() {
+			NETP_ASSERT(m_ringfd == NETP_INVALID_SOCKET);
+			struct io_uring_params p;
+			std::memset(&p, 0, sizeof(p));
+#ifdef IORING_SETUP_COOP_TASKRUN
+			p.flags = IORING_SETUP_COOP_TASKRUN;
+#endif
+			int fd = int(::syscall(__NR_io_uring_setup, NETP_IO_URING_ENTRIES, &p));
+			if ((fd == -1) && (p.flags != 0) && (errno == EINVAL)) {
+				//before 5.19
+				std::memset(&p, 0, sizeof(p));
+				fd = int(::syscall(__NR_io_uring_setup, NETP_IO_URING_ENTRIES, &p));
+			}
+			if (fd == -1) {
+				const int ec = netp_socket_get_last_errno();
+				NETP_WARN("[IO_URING]io_uring_setup failed: %d", ec);
+				return ec;
+			}
+			m_ringfd = fd;
+			m_features = p.features;
+
+			m_sq_sz = p.sq_off.array + p.sq_entries * sizeof(u32_t);
+			m_cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+			if (m_features & IORING_FEAT_SINGLE_MMAP) {
+				m_sq_sz = m_cq_sz = NETP_MAX(m_sq_sz, m_cq_sz);
+			}
+			int rt = netp::OK;
+			m_sq_ptr = ::mmap(0, m_sq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_SQ_RING);
+			if (m_sq_ptr == MAP_FAILED) {
+				m_sq_ptr = 0;
+				rt = netp_socket_get_last_errno();
+				goto _label_setup_failed;
+			}
+			if (m_features & IORING_FEAT_SINGLE_MMAP) {
+				m_cq_ptr = m_sq_ptr;
+			} else {
+				m_cq_ptr = ::mmap(0, m_cq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_CQ_RING);
+				if (m_cq_ptr == MAP_FAILED) {
+					m_cq_ptr = 0;
+					rt = netp_socket_get_last_errno();
+					goto _label_setup_failed;
+				}
+			}
+			m_sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+			m_sqes = (struct io_uring_sqe*)::mmap(0, m_sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_SQES);
+			if (m_sqes == MAP_FAILED) {
+				m_sqes = 0;
+				rt = netp_socket_get_last_errno();
+				goto _label_setup_failed;
+			}
+
+			m_sq_khead = (u32_t*)((byte_t*)m_sq_ptr + p.sq_off.head);
+			m_sq_ktail = (u32_t*)((byte_t*)m_sq_ptr + p.sq_off.tail);
+			m_sq_kflags = (u32_t*)((byte_t*)m_sq_ptr + p.sq_off.flags);
+			m_sq_mask = *(u32_t*)((byte_t*)m_sq_ptr + p.sq_off.ring_mask);
+			m_sq_entries = *(u32_t*)((byte_t*)m_sq_ptr + p.sq_off.ring_entries);
+			m_sq_tail = *m_sq_ktail;
+			{
+				//sqe i always sits at slot i
+				u32_t* sq_array = (u32_t*)((byte_t*)m_sq_ptr + p.sq_off.array);
+				for (u32_t i = 0; i < m_sq_entries; ++i) {
+					sq_array[i] = i;
+				}
+			}
+
+			m_cq_khead = (u32_t*)((byte_t*)m_cq_ptr + p.cq_off.head);
+			m_cq_ktail = (u32_t*)((byte_t*)m_cq_ptr + p.cq_off.tail);
+			m_cq_mask = *(u32_t*)((byte_t*)m_cq_ptr + p.cq_off.ring_mask);
+			m_cqes = (struct io_uring_cqe*)((byte_t*)m_cq_ptr + p.cq_off.cqes);
+
+			NETP_VERBOSE("[IO_URING][##%u]setup io_uring ok, sq: %u, cq: %u, features: %u", m_ringfd, p.sq_entries, p.cq_entries, m_features);
+			return netp::OK;
+
+		_label_setup_failed:
+			NETP_WARN("[IO_URING][##%u]mmap io_uring failed: %d", m_ringfd, rt);
+			__unmap();
+			netp::close(m_ringfd);
+			m_ringfd = NETP_INVALID_SOCKET;
+			return rt;
+		}
+
+		void init() override {
+			if (m_ringfd == NETP_INVALID_SOCKET) {
+				const int rt = setup();
+				if (rt != netp::OK) {
+					NETP_THROW("create io_uring failed");
+				}
+			}
+			poller_interruptable_by_fd::init();
+		}
+
+		void deinit() override {
+			poller_interruptable_by_fd::deinit();
+			NETP_ASSERT(m_ringfd != NETP_INVALID_SOCKET);
+			NETP_VERBOSE("[IO_URING][##%u]deinit begin, pending free: %ld", m_ringfd, m_ctx_pending_free);
+			while (m_ctx_pending_free > 0) {
+				__atomic_store_n(m_sq_ktail, m_sq_tail, __ATOMIC_RELEASE);
+				int rt = __enter(__to_submit(), 1, IORING_ENTER_GETEVENTS, 0, 0);
+				if ((rt == -1) && (netp_socket_get_last_errno() != netp::E_EINTR)) {
+					NETP_ERR("[IO_URING][##%u]deinit wait failed: %d", m_ringfd, netp_socket_get_last_errno());
+					break;
+				}
+				__reap();
+			}
+
+			__unmap();
+
+			int rt = netp::close(m_ringfd);
+			if (-1 == rt) {
+				NETP_THROW("IO_URING::deinit ring handle failed");
+			}
+			NETP_VERBOSE("[IO_URING][##%u]deinit done", m_ringfd);
+			m_ringfd = NETP_INVALID_SOCKET;
+		}
+
+		int poll(i64_t wait_in_nano, std::atomic<bool>& W) override {
+			NETP_ASSERT(m_ringfd != NETP_INVALID_SOCKET);
+
+			u32_t flags = IORING_ENTER_GETEVENTS;
+			u32_t min_complete = 1;
+#ifdef IORING_FEAT_EXT_ARG
+			struct io_uring_getevents_arg arg;
+#endif
+			void* argp = 0;
+			size_t argsz = 0;
+			if (wait_in_nano == 0) {
+				min_complete = 0;
+			} else if (wait_in_nano != ~0) {
+				m_ts.tv_sec = wait_in_nano / i64_t(1000000000);
+				m_ts.tv_nsec = wait_in_nano % i64_t(1000000000);
+#ifdef IORING_FEAT_EXT_ARG
+				if (m_features & IORING_FEAT_EXT_ARG) {
+					std::memset(&arg, 0, sizeof(arg));
+					arg.ts = u64_t(&m_ts);
+					argp = &arg;
+					argsz = sizeof(arg);
+					flags |= IORING_ENTER_EXT_ARG;
+				} else
+#endif
+				{
+					//before 5.11, a timeout sqe wakes us up, a stale one only results in one more wakeup
+					struct io_uring_sqe* sqe = __sqe_get();
+					if (sqe != 0) {
+						sqe->opcode = IORING_OP_TIMEOUT;
+						sqe->fd = -1;
+						sqe->addr = u64_t(&m_ts);
+						sqe->len = 1;
+						sqe->user_data = 0;
+					} else {
+						min_complete = 0;
+					}
+				}
+			}
+
+			//submit the watches of the last iteration and wait in one syscall
+			__atomic_store_n(m_sq_ktail, m_sq_tail, __ATOMIC_RELEASE);
+			const u32_t to_submit = __to_submit();
+			if ((to_submit == 0) && (min_complete == 0)) {
+				NETP_POLLER_WAIT_EXIT(wait_in_nano, W);
+				return __reap();
+			}
+			int rt = __enter(to_submit, min_complete, flags, argp, argsz);
+			NETP_POLLER_WAIT_EXIT(wait_in_nano, W);
+			if (rt == -1) {
+				const int ec = netp_socket_get_last_errno();
+				if ((ec != netp::E_ETIME) && (ec != netp::E_EINTR) && (ec != netp::E_EBUSY)) {
+					NETP_ERR("[IO_URING][##%u]io_uring_enter failed!, errno: %d", m_ringfd, ec);
+					return 0;
+				}
+			}
+			return __reap();
+		}
+	};
+}
+#endif
@@ -40,7 +40,7 @@ namespace netp {
 			m_kevt_size = 0;
 		}
 	
-		void poll(i64_t wait_in_nano, std::atomic<bool>& W) override {
+		int poll(i64_t wait_in_nano, std::atomic<bool>& W) override {
 			struct timespec tsp = {0,0};
 			struct timespec* tspp = 0;
 			if (wait_in_nano != ~0) {
@@ -69,7 +69,9 @@ namespace netp {
 						iom->io_notify_write(ec);
 					}
 				}
+				return rt;
 			}
+			return 0;
 		}
 		int watch( u8_t flag, io_ctx* ctx) {
 			struct kevent ke;
@@ -128,7 +128,7 @@ namespace netp {
 			u8_t m_last_runner_idx;
 		};
 
-	//@please note that, this class is deprecated
+	//@please note that, this class is deprecated, use netp::executor for the new code
 	class scheduler:
 		public netp::singleton<scheduler>
 	{
@@ -23,7 +23,8 @@ namespace netp {
 
 	extern void do_dial(NRP<channel_dial_promise> const& dialp, NRP<address> const& addr, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg);
 
-	extern void do_dial(NRP<channel_dial_promise> const& dialp, netp::size_t idx, std::vector<NRP<address>> const& addrs, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg);
+	//with cfg->dial_race_delay_ms set, a stream dial from idx 0 races the addresses instead of trying them one after another
+	extern void do_dial(NRP<channel_dial_promise> const& dialp, netp::size_t idx, std::vector<NRP<address>, netp::allocator<NRP<address>>> const& addrs, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg);
 	extern void do_dial(NRP<channel_dial_promise> const& dialp, const char* dialurl, size_t len, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg);
 
 	inline static void do_dial(NRP<channel_dial_promise> const& dialp, std::string const& dialurl, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& ccfg) {
@@ -68,5 +69,22 @@ namespace netp {
 	inline static NRP<channel_listen_promise> listen_on(std::string const& listenurl, fn_channel_initializer_t const& initializer) {
 		return listen_on(listenurl.c_str(), listenurl.length(), initializer, netp::make_ref<socket_cfg>(), NETP_DEFAULT_LISTEN_BACKLOG);
 	}
+
+	typedef netp::promise<std::tuple<int, std::vector<NRP<netp::channel>>>> channel_listen_group_promise;
+
+	/*
+	 one SO_REUSEPORT listener per loop of def_loop_group, the kernel spreads the incoming connections over them
+	 and each accepted channel is served on the loop that accepted it, no cross loop handoff
+	 falls back to a single listener if SO_REUSEPORT balancing is not available (non-linux, or port 0)
+	*/
+	extern NRP<channel_listen_group_promise> listen_on_each_loop(const char* listenurl, size_t len, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg, int backlog = NETP_DEFAULT_LISTEN_BACKLOG);
+
+	inline static NRP<channel_listen_group_promise> listen_on_each_loop(std::string const& listenurl, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg, int backlog = NETP_DEFAULT_LISTEN_BACKLOG) {
+		return listen_on_each_loop(listenurl.c_str(), listenurl.length(), initializer, cfg, backlog);
+	}
+
+	inline static NRP<channel_listen_group_promise> listen_on_each_loop(std::string const& listenurl, fn_channel_initializer_t const& initializer) {
+		return listen_on_each_loop(listenurl.c_str(), listenurl.length(), initializer, netp::make_ref<socket_cfg>(), NETP_DEFAULT_LISTEN_BACKLOG);
+	}
 }
 #endif
\ No newline at end of file
@@ -21,6 +21,67 @@
 	#define _NETP_REFIX_EWOULDBLOCK(ec) 
 #endif
 
+//scatter-gather write for stream socket, one sendmsg for multi outbound entry
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID) || defined(_NETP_APPLE)
+	#define NETP_ENABLE_SOCKET_WRITEV
+	#include <limits.h>
+	#ifdef IOV_MAX
+		#define NETP_SOCKET_WRITEV_IOV_MAX (IOV_MAX)
+	#else
+		#define NETP_SOCKET_WRITEV_IOV_MAX (1024)
+	#endif
+#endif
+
+//batched datagram read|write
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID)
+	#define NETP_ENABLE_SOCKET_RECVMMSG
+	#define NETP_ENABLE_SOCKET_SENDMMSG
+#endif
+
+//udp segmentation offload, one sendmsg carries a run of equal-sized datagrams (UDP_SEGMENT), and the receiver get them coalesced (UDP_GRO)
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID)
+	#include <netinet/udp.h>
+	#if defined(UDP_SEGMENT) && defined(UDP_GRO)
+		#define NETP_ENABLE_SOCKET_UDP_GSO
+		//UDP_MAX_SEGMENTS of linux kernel
+		#define NETP_SOCKET_UDP_GSO_MAX_SEGMENTS (64)
+		#define NETP_SOCKET_UDP_GSO_CMSG_SPACE (CMSG_SPACE(sizeof(netp::u16_t)))
+		//the kernel report UDP_GRO by int
+		#define NETP_SOCKET_UDP_GRO_CMSG_SPACE (CMSG_SPACE(sizeof(int)))
+	#endif
+#endif
+
+//MSG_ZEROCOPY transmit for stream socket, the kernel report the completion on the socket error queue
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID)
+	#include <linux/errqueue.h>
+	#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+		#define NETP_ENABLE_SOCKET_ZEROCOPY
+	#endif
+#endif
+
+//busy polling of the device queue on read, SO_PREFER_BUSY_POLL (linux 5.11) keeps the device irq deferred while the app polls
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID)
+	#if defined(SO_BUSY_POLL)
+		#define NETP_ENABLE_SOCKET_BUSY_POLL
+	#endif
+#endif
+
+//file to stream socket by sendfile, the file pages go to the socket without a trip to user space
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID)
+	#include <sys/sendfile.h>
+	#define NETP_ENABLE_SOCKET_SENDFILE
+	//linux sendfile transfers at most 0x7ffff000 bytes per call
+	#define NETP_SOCKET_SENDFILE_MAX (0x7ffff000U)
+#endif
+
+//TCP_INFO of the kernel, glibc's struct tcp_info stops at tcpi_total_retrans, so we read into the layout of linux/tcp.h
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID)
+	#include <netinet/tcp.h>
+	#if defined(TCP_INFO)
+		#define NETP_ENABLE_SOCKET_TCP_INFO
+	#endif
+#endif
+
 namespace netp {
 	
 #ifdef _NETP_WIN
@@ -140,7 +201,8 @@ namespace netp {
 #ifdef _NETP_WIN
 		return WSASocket(family, type, OS_DEF_protocol[protocol], NULL,0,WSA_FLAG_OVERLAPPED);
 #else
-		return ::socket(family, type, OS_DEF_protocol[protocol]);
+		//the protocol of a unix socket only tells stream|datagram in netp
+		return ::socket(family, type, (family == NETP_AF_UNIX) ? 0 : OS_DEF_protocol[protocol]);
 #endif
 	}
 
@@ -149,11 +211,11 @@ namespace netp {
 	}
 
 	inline int connect(SOCKET fd, NRP<address> const& addr) {
-		return ::connect(fd, (const struct sockaddr*)(addr->sockaddr_v4()), sizeof(struct sockaddr_in));
+		return ::connect(fd, addr->sockaddr_raw(), addr->sockaddr_len());
 	}
 
 	inline int bind(SOCKET fd, NRP<address> const& addr) {
-		return ::bind(fd, (const struct sockaddr*)(addr->sockaddr_v4()), sizeof(struct sockaddr_in));
+		return ::bind(fd, addr->sockaddr_raw(), addr->sockaddr_len());
 	}
 
 	inline int shutdown(SOCKET fd, int flag) {
@@ -165,29 +227,29 @@ namespace netp {
 	}
 
 	inline SOCKET accept(SOCKET fd, NRP<address>& from) {
-		socklen_t len = sizeof(struct sockaddr_in);
+		socklen_t len = address::sockaddr_capacity();
 		from = netp::make_ref<address>();
-		::memset((void*)from->sockaddr_v4(), 0, sizeof(struct sockaddr_in));
-		SOCKET accepted_fd = ::accept(fd, from->sockaddr_v4(), &len);
+		SOCKET accepted_fd = ::accept(fd, from->sockaddr_raw(), &len);
 		NETP_RETURN_V_IF_MATCH((SOCKET)NETP_SOCKET_ERROR, (accepted_fd == (SOCKET)NETP_INVALID_SOCKET));
+		from->sockaddr_loaded(len);
 		return accepted_fd;
 	}
 
 	inline int getsockname(SOCKET fd, NRP<address>& addr) {
-		socklen_t len = sizeof(struct sockaddr_in);
+		socklen_t len = address::sockaddr_capacity();
 		addr = netp::make_ref<address>();
-		::memset((void*)addr->sockaddr_v4(), 0, sizeof(struct sockaddr_in));
-		int rt = ::getsockname(fd, addr->sockaddr_v4(), &len);
+		int rt = ::getsockname(fd, addr->sockaddr_raw(), &len);
 		NETP_RETURN_V_IF_MATCH(rt, rt == NETP_SOCKET_ERROR);
+		addr->sockaddr_loaded(len);
 		return netp::OK;
 	}
 
 	inline int getpeername(SOCKET fd, NRP<address>& addr) {
-		socklen_t len = sizeof(struct sockaddr_in);
+		socklen_t len = address::sockaddr_capacity();
 		addr = netp::make_ref<address>();
-		::memset((void*)addr->sockaddr_v4(), 0, sizeof(struct sockaddr_in));
-		int rt = ::getpeername(fd, (struct sockaddr*)(addr->sockaddr_v4()), &len);
+		int rt = ::getpeername(fd, addr->sockaddr_raw(), &len);
 		NETP_RETURN_V_IF_MATCH(rt, rt == NETP_SOCKET_ERROR);
+		addr->sockaddr_loaded(len);
 		return netp::OK;
 	}
 
@@ -272,6 +334,106 @@ __label_send:
 		return r;
 	}
 
+#ifdef NETP_ENABLE_SOCKET_WRITEV
+	//gather write, partial write is possible, caller should advance iov by the return value
+	inline int sendmsg(SOCKET fd, struct iovec* iov, netp::u32_t iovcnt, int flag) {
+		NETP_ASSERT(iov != nullptr && iovcnt>0 && iovcnt <= NETP_SOCKET_WRITEV_IOV_MAX);
+		struct msghdr msg;
+		::memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovcnt;
+__label_sendmsg:
+		const ::ssize_t r = ::sendmsg(fd, &msg, flag);
+		if (NETP_UNLIKELY(r == -1)) {
+			int ec = netp_socket_get_last_errno();
+			if (NETP_UNLIKELY(ec == netp::E_EINTR)) {
+				goto __label_sendmsg;
+			}
+			_NETP_REFIX_EWOULDBLOCK(ec);
+			return ec;
+		}
+		return int(r);
+	}
+#endif
+
+#ifdef NETP_ENABLE_SOCKET_SENDFILE
+	//offset is advanced by the bytes sent, 0 means in_fd reach its end
+	inline int sendfile(SOCKET fd, int in_fd, netp::u64_t& offset, netp::u32_t len) {
+		NETP_ASSERT(len > 0 && len <= NETP_SOCKET_SENDFILE_MAX);
+		off_t off = off_t(offset);
+__label_sendfile:
+		const ::ssize_t r = ::sendfile(fd, in_fd, &off, len);
+		if (NETP_UNLIKELY(r == -1)) {
+			int ec = netp_socket_get_last_errno();
+			if (NETP_UNLIKELY(ec == netp::E_EINTR)) {
+				goto __label_sendfile;
+			}
+			_NETP_REFIX_EWOULDBLOCK(ec);
+			return ec;
+		}
+		offset = netp::u64_t(off);
+		return int(r);
+	}
+#endif
+
+#ifdef NETP_ENABLE_SOCKET_TCP_INFO
+	//struct tcp_info of linux/tcp.h till tcpi_delivery_rate (linux 4.9), an older kernel fills a prefix of it
+	struct tcp_info_raw {
+		netp::u8_t	tcpi_state;
+		netp::u8_t	tcpi_ca_state;
+		netp::u8_t	tcpi_retransmits;
+		netp::u8_t	tcpi_probes;
+		netp::u8_t	tcpi_backoff;
+		netp::u8_t	tcpi_options;
+		netp::u8_t	tcpi_wscale;
+		netp::u8_t	tcpi_app_limited;
+
+		netp::u32_t	tcpi_rto;
+		netp::u32_t	tcpi_ato;
+		netp::u32_t	tcpi_snd_mss;
+		netp::u32_t	tcpi_rcv_mss;
+
+		netp::u32_t	tcpi_unacked;
+		netp::u32_t	tcpi_sacked;
+		netp::u32_t	tcpi_lost;
+		netp::u32_t	tcpi_retrans;
+		netp::u32_t	tcpi_fackets;
+
+		netp::u32_t	tcpi_last_data_sent;
+		netp::u32_t	tcpi_last_ack_sent;
+		netp::u32_t	tcpi_last_data_recv;
+		netp::u32_t	tcpi_last_ack_recv;
+
+		netp::u32_t	tcpi_pmtu;
+		netp::u32_t	tcpi_rcv_ssthresh;
+		netp::u32_t	tcpi_rtt;
+		netp::u32_t	tcpi_rttvar;
+		netp::u32_t	tcpi_snd_ssthresh;
+		netp::u32_t	tcpi_snd_cwnd;
+		netp::u32_t	tcpi_advmss;
+		netp::u32_t	tcpi_reordering;
+
+		netp::u32_t	tcpi_rcv_rtt;
+		netp::u32_t	tcpi_rcv_space;
+
+		netp::u32_t	tcpi_total_retrans;
+
+		netp::u64_t	tcpi_pacing_rate;
+		netp::u64_t	tcpi_max_pacing_rate;
+		netp::u64_t	tcpi_bytes_acked;
+		netp::u64_t	tcpi_bytes_received;
+		netp::u32_t	tcpi_segs_out;
+		netp::u32_t	tcpi_segs_in;
+
+		netp::u32_t	tcpi_notsent_bytes;
+		netp::u32_t	tcpi_min_rtt;
+		netp::u32_t	tcpi_data_segs_in;
+		netp::u32_t	tcpi_data_segs_out;
+
+		netp::u64_t	tcpi_delivery_rate;
+	};
+#endif
+
 	//@note: 
 	//Datagram sockets in various domains(e.g., the UNIXand Internet
 	//	domains) permit zero - length datagrams.When such a datagram is
@@ -307,7 +469,9 @@ __label_recv:
 		NETP_ASSERT(buf != nullptr);
 	_label_sendto:
 		int nbytes;
-		if (addr_to != nullptr) {
+		if (addr_to != nullptr && addr_to->is_unix()) {
+			nbytes = ::sendto(fd, reinterpret_cast<const char*>(buf), (int)len, flag, addr_to->sockaddr_raw(), addr_to->sockaddr_len());
+		} else if (addr_to != nullptr) {
 			struct sockaddr_in addr_in;
 			::memset(&addr_in, 0, sizeof(addr_in));
 			addr_in.sin_family = u16_t(addr_to->family());
@@ -337,8 +501,9 @@ __label_recv:
 		int nbytes;
 		if (addr_o != nullptr) {
 			::memset((void*)addr_o->sockaddr_v4(), 0, sizeof(struct sockaddr_in));
-			socklen_t socklen = sizeof(struct sockaddr_in);
-			nbytes = ::recvfrom(fd, reinterpret_cast<char*>(buff_o), (int)size, flag, addr_o->sockaddr_v4(), &socklen);
+			socklen_t socklen = address::sockaddr_capacity();
+			nbytes = ::recvfrom(fd, reinterpret_cast<char*>(buff_o), (int)size, flag, addr_o->sockaddr_raw(), &socklen);
+			addr_o->sockaddr_loaded(socklen);
 		} else {
 			nbytes = ::recvfrom(fd, reinterpret_cast<char*>(buff_o), (int)size, flag, NULL, NULL);
 		}
@@ -355,6 +520,178 @@ __label_recv:
 		return nbytes;
 	}
 
+#ifdef NETP_ENABLE_SOCKET_RECVMMSG
+	//return the number of datagram received, msg_len of each msgvec is set to the received bytes
+	inline int recvmmsg(SOCKET fd, struct mmsghdr* msgvec, netp::u32_t vlen, int flag) {
+		NETP_ASSERT(msgvec != nullptr && vlen > 0);
+	_label_recvmmsg:
+		const int n = ::recvmmsg(fd, msgvec, vlen, flag, NULL);
+		if (NETP_UNLIKELY(n == -1)) {
+			int ec = netp_socket_get_last_errno();
+			if (ec == netp::E_EINTR) {
+				goto _label_recvmmsg;
+			}
+			_NETP_REFIX_EWOULDBLOCK(ec);
+			return ec;
+		}
+		return n;
+	}
+#endif
+
+#ifdef NETP_ENABLE_SOCKET_SENDMMSG
+	//return the number of datagram sent, it might be less than vlen, an error is returned only if the first one failed
+	inline int sendmmsg(SOCKET fd, struct mmsghdr* msgvec, netp::u32_t vlen, int flag) {
+		NETP_ASSERT(msgvec != nullptr && vlen > 0);
+	_label_sendmmsg:
+		const int n = ::sendmmsg(fd, msgvec, vlen, flag);
+		if (NETP_UNLIKELY(n == -1)) {
+			int ec = netp_socket_get_last_errno();
+			if (ec == netp::E_EINTR) {
+				goto _label_sendmmsg;
+			}
+			_NETP_REFIX_EWOULDBLOCK(ec);
+			return ec;
+		}
+		return n;
+	}
+#endif
+
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+	//return the segment size of a coalesced read, 0 if there is none
+	inline netp::u16_t udp_gro_size(struct msghdr* msg) {
+		for (struct cmsghdr* cm = CMSG_FIRSTHDR(msg); cm != NULL; cm = CMSG_NXTHDR(msg, cm)) {
+			if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+				int gso_size = 0;
+				std::memcpy(&gso_size, CMSG_DATA(cm), sizeof(int));
+				return netp::u16_t(gso_size);
+			}
+		}
+		return 0;
+	}
+
+	//control must be NETP_SOCKET_UDP_GSO_CMSG_SPACE bytes, aligned for cmsghdr
+	inline void __udp_segment_cmsg(struct msghdr* msg, byte_t* control, netp::u16_t gso_size) {
+		msg->msg_control = control;
+		msg->msg_controllen = NETP_SOCKET_UDP_GSO_CMSG_SPACE;
+		struct cmsghdr* cm = CMSG_FIRSTHDR(msg);
+		cm->cmsg_level = SOL_UDP;
+		cm->cmsg_type = UDP_SEGMENT;
+		cm->cmsg_len = CMSG_LEN(sizeof(netp::u16_t));
+		std::memcpy(CMSG_DATA(cm), &gso_size, sizeof(netp::u16_t));
+	}
+
+	//the kernel split buf into gso_size datagrams (the last one might be shorter), return len if all of them are sent
+	inline int sendto_gso(SOCKET fd, netp::byte_t const* const buf, netp::u32_t len, NRP<address> const& addr_to, netp::u16_t gso_size, int flag) {
+		NETP_ASSERT(buf != nullptr && gso_size > 0);
+		struct sockaddr_in addr_in;
+		struct iovec iov = { (void*)buf, len };
+		struct msghdr msg;
+		union {
+			byte_t buf[NETP_SOCKET_UDP_GSO_CMSG_SPACE];
+			struct cmsghdr align;
+		} control;
+		::memset(&msg, 0, sizeof(msg));
+		if (addr_to != nullptr) {
+			::memset(&addr_in, 0, sizeof(addr_in));
+			addr_in.sin_family = u16_t(addr_to->family());
+			addr_in.sin_port = addr_to->nport();
+			addr_in.sin_addr.s_addr = addr_to->nipv4().u32;
+			msg.msg_name = &addr_in;
+			msg.msg_namelen = sizeof(addr_in);
+		}
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		__udp_segment_cmsg(&msg, control.buf, gso_size);
+	_label_sendto_gso:
+		const int nbytes = (int)::sendmsg(fd, &msg, flag);
+		if (NETP_UNLIKELY(nbytes == -1)) {
+			int ec = netp_socket_get_last_errno();
+			if (ec == netp::E_EINTR) {
+				goto _label_sendto_gso;
+			}
+			_NETP_REFIX_EWOULDBLOCK(ec);
+			return ec;
+		}
+		return nbytes;
+	}
+
+	//gro_size_o is set to the segment size if the kernel coalesced several datagrams into buff_o, otherwise 0
+	//trunc_o is set if the read did not fit in size, the tail of it is lost
+	inline int recvfrom_gro(SOCKET fd, byte_t* const buff_o, netp::u32_t size, NRP<address>& addr_o, netp::u16_t& gro_size_o, bool& trunc_o, int flag) {
+		struct iovec iov = { (void*)buff_o, size };
+		struct msghdr msg;
+		union {
+			byte_t buf[NETP_SOCKET_UDP_GRO_CMSG_SPACE];
+			struct cmsghdr align;
+		} control;
+	_label_recvfrom_gro:
+		::memset(&msg, 0, sizeof(msg));
+		if (addr_o != nullptr) {
+			::memset((void*)addr_o->sockaddr_v4(), 0, sizeof(struct sockaddr_in));
+			msg.msg_name = addr_o->sockaddr_v4();
+			msg.msg_namelen = sizeof(struct sockaddr_in);
+		}
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+		const int nbytes = (int)::recvmsg(fd, &msg, flag);
+		if (NETP_UNLIKELY(nbytes == -1)) {
+			int ec = netp_socket_get_last_errno();
+			if (ec == netp::E_EINTR) {
+				goto _label_recvfrom_gro;
+			}
+			_NETP_REFIX_EWOULDBLOCK(ec);
+			return ec;
+		}
+		gro_size_o = udp_gro_size(&msg);
+		trunc_o = (msg.msg_flags & MSG_TRUNC) != 0;
+		return nbytes;
+	}
+#endif
+
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+	//read one notification from the error queue
+	//return 1 if it is a MSG_ZEROCOPY completion of [lo_o, hi_o], copied_o is set if the kernel fallback to copy
+	//return 0 if it is of other origin
+	//return <0 if failed, E_EWOULDBLOCK if the queue is empty
+	inline int recverr_zerocopy(SOCKET fd, netp::u32_t& lo_o, netp::u32_t& hi_o, bool& copied_o) {
+		struct msghdr msg;
+		union {
+			byte_t buf[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+			struct cmsghdr align;
+		} control;
+	_label_recverr:
+		::memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+		const int rt = (int)::recvmsg(fd, &msg, MSG_ERRQUEUE);
+		if (NETP_UNLIKELY(rt == -1)) {
+			int ec = netp_socket_get_last_errno();
+			if (ec == netp::E_EINTR) {
+				goto _label_recverr;
+			}
+			_NETP_REFIX_EWOULDBLOCK(ec);
+			return ec;
+		}
+		for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+			if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+				continue;
+			}
+			struct sock_extended_err serr;
+			std::memcpy(&serr, CMSG_DATA(cm), sizeof(serr));
+			if (serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr.ee_errno != 0) {
+				continue;
+			}
+			lo_o = serr.ee_info;
+			hi_o = serr.ee_data;
+			copied_o = (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+			return 1;
+		}
+		return 0;
+	}
+#endif
+
 	inline int socketpair(int domain, int type, int protocol, SOCKET sv[2]) {
 		if (domain != int(NETP_AF_INET)) {
 			return NETP_SOCKET_ERROR;
@@ -24,11 +24,17 @@ namespace netp {
 		OPTION_NONE = 0,
 		OPTION_BROADCAST = 1, //only for UDP
 		OPTION_REUSEADDR = 1 << 1,
-		OPTION_REUSEPORT = 1 << 2,
+		OPTION_REUSEPORT = 1 << 2, //a setsockopt failure of SO_REUSEPORT fails the socket
 		OPTION_NON_BLOCKING = 1 << 3,
 		OPTION_NODELAY = 1 << 4, //only for TCP
 		OPTION_KEEP_ALIVE = 1 << 5,
-		OPTION_NOCHECK = 1<<6
+		OPTION_NOCHECK = 1<<6,
+		OPTION_WRITE_NOCOPY = 1<<7, //netp level, the outbound packet is referenced instead of being copied
+		OPTION_UDP_GRO = 1<<8, //only for UDP on linux, coalesced datagrams are fired as windows of one buffer, a readfrom handler must not write past the tail of the income packet
+		OPTION_ACCEPT_LOCAL = 1<<9, //netp level, listener only, the accepted channel stays on the loop of the listener instead of def_loop_group()->next()
+		OPTION_WRITE_HOLD = 1<<10, //netp level, a write is queued only, the queue goes out by a flush or at the end of each read batch
+		OPTION_WRITE_BATCH = 1<<11 //netp level, the writes made by the read handlers are held till the end of the read batch, then go out together
+		//@note: the flush at the end of a read batch is opt-in, with neither OPTION_WRITE_HOLD nor OPTION_WRITE_BATCH a write goes out at once
 	};
 
 	const static int default_socket_option = (int(socket_option::OPTION_NON_BLOCKING) | int(socket_option::OPTION_KEEP_ALIVE));
@@ -46,6 +52,26 @@ namespace netp {
 		(netp::u8_t)(NETP_DEFAULT_TCP_KEEPALIVE_PROBES)
 	};
 
+	//@note: a field the kernel does not report is left 0, rtt in microseconds, rates in bytes per second
+	struct socket_tcp_info {
+		u8_t state;
+		u8_t ca_state;
+		u8_t retransmits; //unrecovered rto timeouts
+		u32_t rtt_us;
+		u32_t rttvar_us;
+		u32_t min_rtt_us;
+		u32_t snd_mss;
+		u32_t snd_cwnd; //in segments
+		u32_t snd_ssthresh;
+		u32_t unacked; //in segments
+		u32_t lost;
+		u32_t total_retrans;
+		u32_t notsent_bytes;
+		u64_t bytes_acked;
+		u64_t pacing_rate;
+		u64_t delivery_rate;
+	};
+
 	struct socketinfo {
 		SOCKET fd;
 		u8_t f;
@@ -57,10 +83,11 @@ namespace netp {
 
 		netp::string_t to_string() const {
 			char _buf[1024] = { 0 };
+			const char* pstr = (f == u8_t(NETP_AF_UNIX)) ? ((t == u8_t(NETP_SOCK_STREAM)) ? "UNIX" : "UNIXGRAM") : DEF_protocol_str[int(p)];
 #ifdef _NETP_MSVC
-			int nbytes = snprintf(_buf, 1024, "#%zu:%s:L:%s-R:%s", fd, DEF_protocol_str[int(p)], laddr ? laddr->to_string().c_str():"", raddr?raddr->to_string().c_str():"");
+			int nbytes = snprintf(_buf, 1024, "#%zu:%s:L:%s-R:%s", fd, pstr, laddr ? laddr->to_string().c_str():"", raddr?raddr->to_string().c_str():"");
 #elif defined(_NETP_GCC)
-			int nbytes = snprintf(_buf, 1024, "#%d:%s:L:%s-R:%s", fd, DEF_protocol_str[int(p)], laddr ? laddr->to_string().c_str() : "", raddr ? raddr->to_string().c_str() : "");
+			int nbytes = snprintf(_buf, 1024, "#%d:%s:L:%s-R:%s", fd, pstr, laddr ? laddr->to_string().c_str() : "", raddr ? raddr->to_string().c_str() : "");
 #else
 #error "unknown compiler"
 #endif
@@ -69,6 +96,15 @@ namespace netp {
 		}
 	};
 
+	//one connect of a racing dial, rt is OK for the winner, E_OP_ABORT for the ones cancelled by it
+	struct dial_attempt {
+		NRP<address> addr;
+		int rt;
+		i64_t start_us; //since the dial began
+		i64_t cost_us;
+	};
+	typedef std::function<void(dial_attempt const& attempt)> fn_dial_attempt_t;
+
 	class socket_cfg;
 	typedef std::function<NRP<socket_channel>(NRP<socket_cfg> const& cfg)> fn_socket_channel_maker_t;
 	class socket_cfg final :
@@ -89,7 +125,19 @@ namespace netp {
 		channel_buf_cfg sock_buf;
 		u32_t tx_limit; //in Byte (1kb == 1024Byte), 0 means no limit
 		u32_t wsabuf_size;
-
+		u16_t rcv_batch; //datagrams per read syscall for udp, 0|1 means one recvfrom per datagram
+		u16_t gso_size; //udp only, outlet larger than it is sent as a run of gso_size datagrams by one syscall, 0 means off
+		u32_t zerocopy_threshold; //tcp only, outlet of at least this size is referenced as with OPTION_WRITE_NOCOPY and sent by MSG_ZEROCOPY, 0 means off
+		u32_t read_buf_min; //stream only, read buffer adapts to the recent reads in [read_buf_min, read_buf_max]
+		u32_t read_buf_max; //0 means a fixed size of event_loop_cfg::channel_read_buf_size
+		u32_t read_budget_bytes; //bytes read per wakeup before yielding to the other channels of the loop, 0 means no limit
+		u16_t read_budget_count; //read syscalls per wakeup before yielding, 0 means no limit
+		u32_t write_buf_high; //ch_is_writable() turns false once the queued outbound bytes go above it, 0 means off
+		u32_t write_buf_low; //ch_is_writable() turns back to true once the queued bytes drain to it, 0 means half of the high one
+		u32_t busy_poll_us; //SO_BUSY_POLL in us, SO_PREFER_BUSY_POLL is also set if supported, 0 means off
+		u32_t dial_race_delay_ms; //stream dial only, the next resolved address is tried after this delay or once the previous one failed, the first connected wins, 0 means one after another
+
+		fn_dial_attempt_t dial_attempt_report; //called in L for each attempt of a racing dial
 		fn_socket_channel_maker_t ch_maker;
 		socket_cfg(NRP<event_loop> const& L = nullptr) :
 			L(L),
@@ -104,6 +152,18 @@ namespace netp {
 			sock_buf({ 0 }),
 			tx_limit(0),
 			wsabuf_size(64*1024),
+			rcv_batch(1),
+			gso_size(0),
+			zerocopy_threshold(0),
+			read_buf_min(0),
+			read_buf_max(0),
+			read_budget_bytes(0),
+			read_budget_count(0),
+			write_buf_high(0),
+			write_buf_low(0),
+			busy_poll_us(0),
+			dial_race_delay_ms(0),
+			dial_attempt_report(nullptr),
 			ch_maker(nullptr)
 		{}
 
@@ -121,20 +181,129 @@ namespace netp {
 			_cfg->sock_buf = sock_buf;
 			_cfg->tx_limit = tx_limit;
 			_cfg->wsabuf_size = wsabuf_size;
+			_cfg->rcv_batch = rcv_batch;
+			_cfg->gso_size = gso_size;
+			_cfg->zerocopy_threshold = zerocopy_threshold;
+			_cfg->read_buf_min = read_buf_min;
+			_cfg->read_buf_max = read_buf_max;
+			_cfg->read_budget_bytes = read_budget_bytes;
+			_cfg->read_budget_count = read_budget_count;
+			_cfg->write_buf_high = write_buf_high;
+			_cfg->write_buf_low = write_buf_low;
+			_cfg->busy_poll_us = busy_poll_us;
+			_cfg->dial_race_delay_ms = dial_race_delay_ms;
+			_cfg->dial_attempt_report = dial_attempt_report;
 			_cfg->ch_maker = ch_maker;
 
 			return _cfg;
 		}
 	};
 
+	//a range of file sent by sendfile, the bytes are not buffered, they are counted to m_tx_file_bytes instead of m_tx_bytes
+	struct socket_outbound_file final :
+		public netp::ref_base
+	{
+		int fd;
+		u64_t offset;
+		u64_t len;
+		socket_outbound_file(int fd_, u64_t offset_, u64_t len_) :
+			fd(fd_),
+			offset(offset_),
+			len(len_)
+		{}
+	};
+
+	//@note: a copied write is a private non_atomic_ref_packet in data, it's skipped in place on a partial write
+	//with OPTION_WRITE_NOCOPY, ref is the very packet passed to ch_write, it must not be modified by the writer until write_promise is set
+	//the channel never modifies ref, offset is the count of its bytes written
+	//an entry with a non-null file has neither data nor ref
 	struct socket_outbound_entry final {
 		NRP<non_atomic_ref_packet> data;
+		NRP<packet> ref;
+		u32_t offset;
 		NRP<promise<int>> write_promise;
+		NRP<socket_outbound_file> file;
+
+		__NETP_FORCE_INLINE byte_t* head() const {
+			return data != nullptr ? data->head() : (ref->head() + offset);
+		}
+		__NETP_FORCE_INLINE u32_t len() const {
+			return data != nullptr ? data->len() : (ref->len() - offset);
+		}
+		inline void skip(u32_t nbytes) {
+			NETP_ASSERT(nbytes < len());
+			if (data != nullptr) {
+				data->skip(nbytes);
+			} else {
+				offset += nbytes;
+			}
+		}
 	};
+	//@note: data or ref, as socket_outbound_entry does, a datagram is never sent in part
 	struct socket_outbound_entry_to final {
 		NRP<non_atomic_ref_packet> data;
+		NRP<packet> ref;
 		NRP<promise<int>> write_promise;
 		NRP<address> to;
+		u16_t gso_size; //0 means one datagram
+
+		__NETP_FORCE_INLINE byte_t* head() const {
+			return data != nullptr ? data->head() : ref->head();
+		}
+		__NETP_FORCE_INLINE u32_t len() const {
+			return data != nullptr ? data->len() : ref->len();
+		}
+	};
+
+	//@note: the kernel reference the pages of data until the completion of id is read from the error queue, the write_promise is set by then
+	//an entry with a nullptr data is a write done by copy after a pending zerocopy one, it's queued to keep the order of write_promise
+	struct socket_zerocopy_entry final {
+		NRP<packet> data;
+		NRP<promise<int>> write_promise;
+		u32_t id;
+		bool done;
+	};
+
+	//@note: netty style, grow by two classes on a full read, shrink by one class after two wakeups in a row that read less than the lower class
+	struct socket_rcv_sizer final {
+		u8_t cls;
+		u8_t cls_min;
+		u8_t cls_max;
+		bool shrink_pending;
+
+		//the pool slot of (1<<(cls+8)) has room for the packet reserve, just like PACK_DEF_RIGHT_CAPACITY does
+		static inline u32_t cls_size(u8_t c) {
+			return (1U << (c + 8)) - (PACK_DEF_LEFT_CAPACITY + 64);
+		}
+
+		void init(u32_t min, u32_t max) {
+			cls_min = 0;
+			while ((cls_min < NETP_SOCKET_RCV_SIZER_CLASS_MAX) && (cls_size(cls_min) < min)) {
+				++cls_min;
+			}
+			cls_max = cls_min;
+			while ((cls_max < NETP_SOCKET_RCV_SIZER_CLASS_MAX) && (cls_size(cls_max + 1) <= max)) {
+				++cls_max;
+			}
+			cls = NETP_MIN(NETP_MAX(u8_t(NETP_SOCKET_RCV_SIZER_CLASS_INIT), cls_min), cls_max);
+			shrink_pending = false;
+		}
+
+		inline u32_t size() const {
+			return cls_size(cls);
+		}
+
+		void record(u32_t nbytes) {
+			if ((cls > cls_min) && (nbytes <= cls_size(cls - 1))) {
+				if (shrink_pending) {
+					--cls;
+				}
+				shrink_pending = !shrink_pending;
+			} else if (nbytes >= cls_size(cls)) {
+				cls = NETP_MIN(u8_t(cls + 2), cls_max);
+				shrink_pending = false;
+			}
+		}
 	};
 
 	//@note: 1kb for delta checker
@@ -147,6 +316,7 @@ namespace netp {
 		friend void do_listen_on(NRP<channel_listen_promise> const& listenp, NRP<address> const& laddr, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg, int backlog);
 		typedef std::deque<socket_outbound_entry, netp::allocator<socket_outbound_entry>> socket_outbound_entry_t;
 		typedef std::deque<socket_outbound_entry_to, netp::allocator<socket_outbound_entry_to>> socket_outbound_entry_to_t;
+		typedef std::deque<socket_zerocopy_entry, netp::allocator<socket_zerocopy_entry>> socket_zerocopy_entry_t;
 
 		template <class _Ref_ty, typename... _Args>
 		friend ref_ptr<_Ref_ty> make_ref(_Args&&... args);
@@ -167,10 +337,26 @@ namespace netp {
 		u32_t m_tx_limit; //in byte
 		u32_t m_tx_budget;
 		u32_t m_tx_bytes;
+		u64_t m_tx_file_bytes; //the bytes of the queued files, not buffered, counted to the watermarks only
+		u16_t m_rcv_batch;
+		u16_t m_gso_size;
+		u32_t m_zc_threshold;
+		u32_t m_zc_id; //id of the next MSG_ZEROCOPY send
+		socket_rcv_sizer m_rcv_sizer;
+		bool m_rcv_adaptive;
+		u16_t m_rcv_budget_count;
+		u32_t m_rcv_budget_bytes;
+		u32_t m_tx_high;
+		u32_t m_tx_low;
+		bool m_tx_writable_fired; //the state carried by the last writability_changed
+		bool m_tx_writability_pending;
+		u32_t m_busy_poll_us;
+		u32_t m_rcv_truncated; //coalesced reads dropped for not fitting in the read buffer
 
 		//@note: for long term session, we should better release the q if necessary
 		socket_outbound_entry_t m_tx_entry_q;
 		socket_outbound_entry_to_t m_tx_entry_to_q;
+		socket_zerocopy_entry_t m_tx_zc_q;
 
 		void _tmcb_tx_limit(NRP<timer> const& t);
 
@@ -189,9 +375,26 @@ namespace netp {
 			m_tx_limit_last_tp(0),
 			m_tx_limit((cfg->tx_limit != 0 && cfg->tx_limit < _NETP_SOCKET_CHANNEL_LIMIT_MIN) ? _NETP_SOCKET_CHANNEL_LIMIT_MIN : cfg->tx_limit),
 			m_tx_budget( (cfg->tx_limit != 0 && cfg->tx_limit < _NETP_SOCKET_CHANNEL_LIMIT_MIN) ? _NETP_SOCKET_CHANNEL_LIMIT_MIN : cfg->tx_limit ),
-			m_tx_bytes(0)
+			m_tx_bytes(0),
+			m_tx_file_bytes(0),
+			m_rcv_batch(cfg->rcv_batch > NETP_SOCKET_RCV_BATCH_MAX ? u16_t(NETP_SOCKET_RCV_BATCH_MAX) : cfg->rcv_batch),
+			m_gso_size(cfg->gso_size),
+			m_zc_threshold(cfg->zerocopy_threshold),
+			m_zc_id(0),
+			m_rcv_adaptive((cfg->read_buf_max != 0) && (cfg->type == NETP_SOCK_STREAM)),
+			m_rcv_budget_count(cfg->read_budget_count),
+			m_rcv_budget_bytes(cfg->read_budget_bytes),
+			m_tx_high(cfg->write_buf_high),
+			m_tx_low( (cfg->write_buf_low != 0 && cfg->write_buf_low < cfg->write_buf_high) ? cfg->write_buf_low : (cfg->write_buf_high>>1) ),
+			m_tx_writable_fired(true),
+			m_tx_writability_pending(false),
+			m_busy_poll_us(cfg->busy_poll_us),
+			m_rcv_truncated(0)
 		{
 			NETP_ASSERT(cfg->L != nullptr);
+			if (m_rcv_adaptive) {
+				m_rcv_sizer.init(cfg->read_buf_min, cfg->read_buf_max);
+			}
 			if (cfg->fd != NETP_INVALID_SOCKET) {
 				//@note: for unix_sock|pipe, there is no laddr&raddr
 				NETP_ASSERT((m_laddr != nullptr) || (m_raddr !=nullptr) );
@@ -462,6 +665,75 @@ protected:
 			return netp::OK;
 		}
 
+		int _cfg_gro(bool onoff) {
+			NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, m_fd == NETP_INVALID_SOCKET);
+			NETP_RETURN_V_IF_NOT_MATCH(netp::E_INVALID_OPERATION, m_protocol == u8_t(NETP_PROTOCOL_UDP));
+
+			bool setornot = ((m_option & u16_t(socket_option::OPTION_UDP_GRO)) && (!onoff)) ||
+				(((m_option & u16_t(socket_option::OPTION_UDP_GRO)) == 0) && (onoff));
+
+			if (!setornot) {
+				return netp::OK;
+			}
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+			int optval = onoff ? 1 : 0;
+			int rt = socket_setsockopt_impl(SOL_UDP, UDP_GRO, &optval, sizeof(optval));
+			NETP_RETURN_V_IF_MATCH(netp_socket_get_last_errno(), rt == NETP_SOCKET_ERROR);
+			if (onoff) {
+				m_option |= u16_t(socket_option::OPTION_UDP_GRO);
+			} else {
+				m_option &= ~u16_t(socket_option::OPTION_UDP_GRO);
+			}
+			return netp::OK;
+#else
+			return netp::E_EOPNOTSUPP;
+#endif
+		}
+
+		//fallback to copy if SO_ZEROCOPY is not supported
+		int _cfg_zerocopy() {
+			if (m_zc_threshold == 0) {
+				return netp::OK;
+			}
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+			int optval = 1;
+			int rt = socket_setsockopt_impl(SOL_SOCKET, SO_ZEROCOPY, &optval, sizeof(optval));
+			if (rt == NETP_SOCKET_ERROR) {
+				NETP_WARN("[socket][%s]SO_ZEROCOPY failed: %d, fallback to copy", ch_info().c_str(), netp_socket_get_last_errno());
+				m_zc_threshold = 0;
+			}
+#else
+			m_zc_threshold = 0;
+#endif
+			return netp::OK;
+		}
+
+		//SO_BUSY_POLL above net.core.busy_read requires CAP_NET_ADMIN, go on without it if it's refused
+		int _cfg_busy_poll() {
+			if (m_busy_poll_us == 0) {
+				return netp::OK;
+			}
+#ifdef NETP_ENABLE_SOCKET_BUSY_POLL
+			int optval = int(m_busy_poll_us);
+			int rt = socket_setsockopt_impl(SOL_SOCKET, SO_BUSY_POLL, &optval, sizeof(optval));
+			if (rt == NETP_SOCKET_ERROR) {
+				NETP_WARN("[socket][%s]SO_BUSY_POLL failed: %d", ch_info().c_str(), netp_socket_get_last_errno());
+				m_busy_poll_us = 0;
+				return netp::OK;
+			}
+	#ifdef SO_PREFER_BUSY_POLL
+			optval = 1;
+			rt = socket_setsockopt_impl(SOL_SOCKET, SO_PREFER_BUSY_POLL, &optval, sizeof(optval));
+			if (rt == NETP_SOCKET_ERROR) {
+				NETP_WARN("[socket][%s]SO_PREFER_BUSY_POLL failed: %d", ch_info().c_str(), netp_socket_get_last_errno());
+			}
+	#endif
+#else
+			m_busy_poll_us = 0;
+#endif
+			return netp::OK;
+		}
+
 		int _cfg_option(u16_t opt, keep_alive_vals const& kvals) {
 
 			//force nonblocking
@@ -471,26 +743,60 @@ protected:
 			rt = _cfg_reuseaddr((opt & u16_t(socket_option::OPTION_REUSEADDR)) != 0);
 			NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 
+			if (opt & u16_t(socket_option::OPTION_WRITE_NOCOPY)) {
+				m_option |= u16_t(socket_option::OPTION_WRITE_NOCOPY);
+			} else {
+				m_option &= ~u16_t(socket_option::OPTION_WRITE_NOCOPY);
+			}
+
+			if (opt & u16_t(socket_option::OPTION_WRITE_BATCH)) {
+				m_option |= u16_t(socket_option::OPTION_WRITE_BATCH);
+			} else {
+				m_option &= ~u16_t(socket_option::OPTION_WRITE_BATCH);
+			}
+
+			if (opt & u16_t(socket_option::OPTION_WRITE_HOLD)) {
+				m_option |= u16_t(socket_option::OPTION_WRITE_HOLD);
+				m_chflag |= int(channel_flag::F_WRITE_HOLD);
+			} else {
+				m_option &= ~u16_t(socket_option::OPTION_WRITE_HOLD);
+				m_chflag &= ~int(channel_flag::F_WRITE_HOLD);
+			}
+
 #if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID) || defined(_NETP_APPLE)
-			rt = _cfg_reuseport((m_option & u8_t(socket_option::OPTION_REUSEPORT)) != 0);
-			NETP_RETURN_V_IF_MATCH(NETP_SOCKET_ERROR, rt == NETP_SOCKET_ERROR);
+			//@note: behavior change, this used to test m_option, which has no REUSEPORT bit here yet, so OPTION_REUSEPORT never reached the socket
+			//a socket asking for it now gets SO_REUSEPORT, and fails with the errno if the kernel refuses it
+			rt = _cfg_reuseport((opt & u16_t(socket_option::OPTION_REUSEPORT)) != 0);
+			NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 #endif
 
-			if (is_udp()) {
+			//@note: a unix socket takes the stream|datagram path of tcp|udp, but none of the ip level options
+			if (is_udp() && !is_unix()) {
 				rt = _cfg_nocheck((opt & u16_t(socket_option::OPTION_NOCHECK)) != 0);
 				NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 
 				rt = _cfg_broadcast((opt & u16_t(socket_option::OPTION_BROADCAST)) != 0);
 				NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
+
+				rt = _cfg_gro((opt & u16_t(socket_option::OPTION_UDP_GRO)) != 0);
+				NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 			}
 
-			if (is_tcp()) {
+			if (is_tcp() && !is_unix()) {
 				rt = _cfg_nodelay((opt & u16_t(socket_option::OPTION_NODELAY)) != 0);
 				NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 
 				rt = _cfg_keepalive((opt & u16_t(socket_option::OPTION_KEEP_ALIVE)) != 0, kvals);
 				NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
+
+				rt = _cfg_zerocopy();
+				NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
+			} else {
+				m_zc_threshold = 0;
 			}
+
+			rt = _cfg_busy_poll();
+			NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 			return netp::OK;
 		}
 
@@ -575,16 +881,51 @@ protected:
 		virtual int socket_send_impl(const byte_t* data, u32_t len, int flag = 0) {
 			return netp::send(m_fd, data, len, flag);
 		}
+#ifdef NETP_ENABLE_SOCKET_WRITEV
+		//@note: a custom socket that overrides socket_send_impl should override this one as well
+		virtual int socket_sendmsg_impl(struct iovec* iov, u32_t iovcnt, int flag = 0) {
+			return netp::sendmsg(m_fd, iov, iovcnt, flag);
+		}
+#endif
+#ifdef NETP_ENABLE_SOCKET_SENDFILE
+		virtual int socket_sendfile_impl(int in_fd, u64_t& offset, u32_t len) {
+			return netp::sendfile(m_fd, in_fd, offset, len);
+		}
+#endif
 		virtual int socket_sendto_impl(const byte_t* data, u32_t len, NRP<address> const& to, int flag = 0) {
 			return netp::sendto(m_fd, data, len, to, flag);
 		}
 
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+		virtual int socket_recverr_zerocopy_impl(u32_t& lo, u32_t& hi, bool& copied) {
+			return netp::recverr_zerocopy(m_fd, lo, hi, copied);
+		}
+#endif
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+		virtual int socket_sendto_gso_impl(const byte_t* data, u32_t len, NRP<address> const& to, u16_t gso_size, int flag = 0) {
+			return netp::sendto_gso(m_fd, data, len, to, gso_size, flag);
+		}
+		virtual int socket_recvfrom_gro_impl(byte_t* const buf, u32_t size, NRP<address>& from, u16_t& gro_size, bool& trunc, int flag = 0) {
+			return netp::recvfrom_gro(m_fd, buf, size, from, gro_size, trunc, flag);
+		}
+#endif
+
 		virtual int socket_recv_impl(byte_t* const buf, u32_t size, int flag = 0) {
 			return netp::recv(m_fd, buf, size, flag);
 		}
 		virtual int socket_recvfrom_impl(byte_t* const buf, u32_t size, NRP<address>& from, int flag = 0) {
 			return netp::recvfrom(m_fd, buf, size, from, flag);
 		}
+#ifdef NETP_ENABLE_SOCKET_SENDMMSG
+		virtual int socket_sendmmsg_impl(struct mmsghdr* msgvec, u32_t vlen, int flag = 0) {
+			return netp::sendmmsg(m_fd, msgvec, vlen, flag);
+		}
+#endif
+#ifdef NETP_ENABLE_SOCKET_RECVMMSG
+		virtual int socket_recvmmsg_impl(struct mmsghdr* msgvec, u32_t vlen, int flag = 0) {
+			return netp::recvmmsg(m_fd, msgvec, vlen, flag);
+		}
+#endif
 
 	public:
 		__NETP_FORCE_INLINE u8_t sock_family() const { return ((m_family)); };
@@ -596,6 +937,7 @@ protected:
 		__NETP_FORCE_INLINE bool is_tcp() const { return m_protocol == u8_t(NETP_PROTOCOL_TCP); }
 		__NETP_FORCE_INLINE bool is_udp() const { return m_protocol == u8_t(NETP_PROTOCOL_UDP); }
 		__NETP_FORCE_INLINE bool is_icmp() const { return m_protocol == u8_t(NETP_PROTOCOL_ICMP); }
+		__NETP_FORCE_INLINE bool is_unix() const { return m_family == u8_t(NETP_AF_UNIX); }
 
 		__NETP_FORCE_INLINE SOCKET fd() const { return m_fd; }
 		__NETP_FORCE_INLINE NRP<address> const& remote_addr() const { return m_raddr; }
@@ -643,7 +985,7 @@ protected:
 		int load_peername() {
 			int rt = socket_getpeername_impl(m_raddr);
 			if (rt == netp::OK) {
-				NETP_ASSERT(m_raddr->family() == NETP_AF_INET);
+				NETP_ASSERT(m_raddr->family() == m_family);
 				NETP_ASSERT(!m_laddr->is_af_unspec());
 				return netp::OK;
 			}
@@ -691,6 +1033,9 @@ protected:
 		int get_tos(u8_t& tos) const;
 		int cfg_tos(u8_t tos);
 
+		//call it in L, return E_EOPNOTSUPP if the platform does not have TCP_INFO
+		int get_tcp_info(socket_tcp_info& info) const;
+
 		int ch_init(u16_t opt, keep_alive_vals const& kvals, channel_buf_cfg const& cbc) {
 			NETP_ASSERT(L->in_event_loop());
 			//@note: F_CLOSED SHOULD ALWAYS BE CLEARED ONCE fd is set
@@ -740,6 +1085,16 @@ protected:
 		void do_listen_on(NRP<promise<int>> const& intp, NRP<address> const& addr, fn_channel_initializer_t const& fn_accepted, NRP<socket_cfg> const& ccfg, int backlog = NETP_DEFAULT_LISTEN_BACKLOG);
 		void do_dial(NRP<promise<int>> const& dialp, NRP<address> const& addr, fn_channel_initializer_t const& fn_initializer);
 
+		//call it in L, the pending connect fails with cancel_code, no-op if there is not any
+		void ch_cancel_connect(int cancel_code) {
+			NETP_ASSERT(L->in_event_loop());
+			NETP_ASSERT(cancel_code != netp::OK);
+			if ((m_chflag & int(channel_flag::F_CONNECTING)) == 0) {
+				return;
+			}
+			__ch_io_cancel_connect(cancel_code, m_io_ctx);
+		}
+
 		void _ch_do_close_read() {
 			if (m_chflag & (int(channel_flag::F_READ_SHUTDOWNING)|int(channel_flag::F_READ_SHUTDOWN)) ) { return; }
 
@@ -767,13 +1122,32 @@ protected:
 			NETP_ASSERT( ch_is_connected() ? m_tx_entry_to_q.empty() : m_tx_entry_q.empty(), "flag: %u", m_chflag );
 #endif
 
+			//the completion of these ones would never be read, they were written ahead of m_tx_entry_q
+			while (m_tx_zc_q.size()) {
+				NETP_ASSERT((ch_errno() != 0) && (m_chflag & (int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_READ_ERROR) | int(channel_flag::F_FIRE_ACT_EXCEPTION))));
+				NRP<promise<int>> wp = std::move(m_tx_zc_q.front().write_promise);
+				m_tx_zc_q.pop_front();
+				if (wp != nullptr) {
+					wp->set(ch_errno());
+				}
+			}
+
 			while (m_tx_entry_q.size()) {
 				NETP_ASSERT((ch_errno() != 0) && (m_chflag & (int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_READ_ERROR) | int(channel_flag::F_FIRE_ACT_EXCEPTION))));
 				socket_outbound_entry& entry = m_tx_entry_q.front();
-				NETP_WARN("[socket][%s]cancel outbound, nbytes:%u, errno: %d", ch_info().c_str(), entry.data->len(), ch_errno());
+				if (entry.file != nullptr) {
+					NETP_WARN("[socket][%s]cancel outbound file, nbytes:%llu, errno: %d", ch_info().c_str(), entry.file->len, ch_errno());
+					NRP<promise<int>> fwp = entry.write_promise;
+					m_tx_file_bytes -= entry.file->len;
+					m_tx_entry_q.pop_front();
+					NETP_ASSERT(fwp->is_idle());
+					fwp->set(ch_errno());
+					continue;
+				}
+				NETP_WARN("[socket][%s]cancel outbound, nbytes:%u, errno: %d", ch_info().c_str(), entry.len(), ch_errno());
 				//hold a copy before we do pop it from queue
 				NRP<promise<int>> wp = entry.write_promise;
-				m_tx_bytes -= u32_t(entry.data->len());
+				m_tx_bytes -= u32_t(entry.len());
 				m_tx_entry_q.pop_front();
 				NETP_ASSERT(wp->is_idle());
 				wp->set(ch_errno());
@@ -782,10 +1156,10 @@ protected:
 			while (m_tx_entry_to_q.size()) {
 				NETP_ASSERT((ch_errno() != 0) && (m_chflag & (int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_READ_ERROR) | int(channel_flag::F_FIRE_ACT_EXCEPTION))));
 				socket_outbound_entry_to& entry = m_tx_entry_to_q.front();
-				NETP_WARN("[socket][%s]cancel outbound, nbytes:%u, errno: %d, to: %s", ch_info().c_str(), entry.data->len(), ch_errno(), entry.to && !entry.to->is_af_unspec() ? entry.to->to_string().c_str() : "");
+				NETP_WARN("[socket][%s]cancel outbound, nbytes:%u, errno: %d, to: %s", ch_info().c_str(), entry.len(), ch_errno(), entry.to && !entry.to->is_af_unspec() ? entry.to->to_string().c_str() : "");
 				//hold a copy before we do pop it from queue
 				NRP<promise<int>> wp = entry.write_promise;
-				m_tx_bytes -= u32_t(entry.data->len());
+				m_tx_bytes -= u32_t(entry.len());
 				m_tx_entry_to_q.pop_front();
 				NETP_ASSERT(wp->is_idle());
 				wp->set(ch_errno());
@@ -876,10 +1250,45 @@ protected:
 			}
 		}
 
+		__NETP_FORCE_INLINE bool __rcv_budget_exhausted(u32_t reads, u32_t nbytes) const {
+			return ((m_rcv_budget_count != 0) && (reads >= m_rcv_budget_count)) ||
+				((m_rcv_budget_bytes != 0) && (nbytes >= m_rcv_budget_bytes));
+		}
+		//@note: the fd stays readable without a new edge, so the left read is scheduled behind the ready set and the pending tasks
+		void __rcv_budget_requeue();
+
 		void __do_io_read_from(int status, io_ctx* ctx);
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+		//fire the coalesced datagrams of buf one by one, nbytes in total
+		void __do_io_read_from_gro_fire(NRP<packet> const& buf, u32_t nbytes, u16_t gro_size, NRP<address> const& from);
+		//a coalesced read larger than the buffer lost its tail, the segments can not be told apart any more, drop it
+		void __do_io_read_from_gro_truncated(u32_t nbytes);
+#endif
+#ifdef NETP_ENABLE_SOCKET_RECVMMSG
+		void __do_io_read_from_batch(int status, io_ctx* ctx);
+#endif
 		void __do_io_read(int status, io_ctx* ctx);
 
+		__NETP_FORCE_INLINE void __tx_watermark_check() {
+			if (m_tx_high == 0) {
+				return;
+			}
+			const u64_t tx_bytes = u64_t(m_tx_bytes) + m_tx_file_bytes;
+			if ((m_chflag & int(channel_flag::F_UNWRITABLE)) == 0) {
+				if (tx_bytes > m_tx_high) {
+					m_chflag |= int(channel_flag::F_UNWRITABLE);
+					__tx_writability_changed();
+				}
+			} else if (tx_bytes <= m_tx_low) {
+				m_chflag &= ~int(channel_flag::F_UNWRITABLE);
+				__tx_writability_changed();
+			}
+		}
+		//@note: fired by a task, a crossing happens in the middle of ch_write or a write_promise callback
+		void __tx_writability_changed();
+
 		inline void __do_io_write_done(const int status) {
+			__tx_watermark_check();
 			switch (status) {
 			case netp::OK:
 			{
@@ -903,11 +1312,12 @@ protected:
 			case netp::E_EWOULDBLOCK:
 			{
 #ifdef _NETP_DEBUG
-				NETP_ASSERT(ch_is_connected() ? m_tx_entry_q.size() : m_tx_entry_to_q.size(), "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
+				NETP_ASSERT(ch_is_connected() ? (m_tx_entry_q.size() || m_tx_zc_q.size()) : m_tx_entry_to_q.size(), "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
 #endif
 
 #ifdef NETP_ENABLE_FAST_WRITE
 				NETP_ASSERT(m_chflag & (int(channel_flag::F_WRITE_BARRIER)) );
+				m_io_ctx->flag |= io_flag::IO_EPOLL_WRITE_BLOCKED;
 				ch_io_write();
 #else
 				NETP_ASSERT(m_chflag & (int(channel_flag::F_WRITE_BARRIER) | int(channel_flag::F_WATCH_WRITE)) == (int(channel_flag::F_WRITE_BARRIER) | int(channel_flag::F_WATCH_WRITE))  );
@@ -941,20 +1351,55 @@ protected:
 		//==0, flush done
 		//this api would be called right after a check of writeable of the current socket
 		int ___do_io_write();
+#ifdef NETP_ENABLE_SOCKET_WRITEV
+		//gather up to NETP_SOCKET_WRITEV_IOV_MAX entries into one sendmsg for stream socket
+		int ___do_io_writev();
+#ifdef NETP_ENABLE_SOCKET_SENDFILE
+		//sendfile the front entry, it's popped once the whole range is sent
+		int ___do_io_write_file();
+#endif
+#endif
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+		//send the front entry by MSG_ZEROCOPY, move it to m_tx_zc_q once it is done
+		int ___do_io_write_zerocopy(u32_t wlen_max);
+		//set the write_promise of the completed ones in order
+		void __tx_zerocopy_done(u32_t lo, u32_t hi);
+#endif
 		int ___do_io_write_to();
+#ifdef NETP_ENABLE_SOCKET_SENDMMSG
+		//flush up to NETP_SOCKET_SND_BATCH_MAX datagrams per sendmmsg, each one with its own destination
+		int ___do_io_write_to_batch();
+#endif
+		void __tx_limit_consume(u32_t nbytes);
 
 		//for connected socket type
 		void _ch_do_close_listener();
 		void _ch_do_close_read_write();
 
-		virtual void __io_begin_done(io_ctx*) {
+		virtual void __io_begin_done(io_ctx* ctx) {
 			m_chflag |= int(channel_flag::F_IO_EVENT_LOOP_BEGIN_DONE);
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+			if (m_zc_threshold != 0) {
+				ctx->flag |= io_flag::IO_ERRQUEUE;
+			}
+#else
+			(void)ctx;
+#endif
 		}
 
 		void ch_write_impl(NRP<promise<int>> const& intp, NRP<packet> const& outlet) override;
 		void ch_write_to_impl(NRP<promise<int>> const& intp, NRP<packet> const& outlet, NRP<netp::address> const& to) override;
+		void ch_write_file_impl(NRP<promise<int>> const& intp, int fd, u64_t offset, u64_t len) override;
+		void ch_flush_impl() override;
+		void __ch_write_to_impl(NRP<promise<int>> const& intp, NRP<packet> const& outlet, NRP<netp::address> const& to, u16_t gso_size);
 
 		void ch_close_read_impl(NRP<promise<int>> const& closep) override;
+		//a graceful close takes the held writes with it
+		__NETP_FORCE_INLINE void __ch_flush_held() {
+			if ((m_chflag & int(channel_flag::F_WRITE_HOLD)) && (m_tx_entry_q.size() || m_tx_entry_to_q.size())) {
+				ch_flush_impl();
+			}
+		}
 		void ch_close_write_impl(NRP<promise<int>> const& chp) override;
 		void ch_close_impl(NRP<promise<int>> const& chp) override;
 
@@ -962,6 +1407,9 @@ protected:
 		virtual void io_notify_terminating(int status, io_ctx*) override;
 		virtual void io_notify_read(int status, io_ctx* ctx) override;
 		virtual void io_notify_write(int status, io_ctx* ctx) override;
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+		virtual void io_notify_errqueue(int status, io_ctx* ctx) override;
+#endif
 		
 		virtual void __ch_clean();
 		virtual void __ch_io_cancel_connect(int cancel_code, io_ctx* ctx_) {
@@ -996,6 +1444,11 @@ protected:
 			ch_io_end_write();
 		}
 
+		//count of the coalesced udp reads dropped as truncated, read it on the loop
+		u32_t ch_rcv_truncated() const {
+			return m_rcv_truncated;
+		}
+
 		NRP<promise<int>> ch_set_read_buffer_size(u32_t size) override {
 			NRP<promise<int>> chp = make_ref<promise<int>>();
 			L->execute([S = NRP<socket_channel>(this), size, chp]() {
@@ -1040,6 +1493,16 @@ protected:
 		netp::string_t ch_info() const override {
 			return socketinfo{ m_fd, (m_family),(m_type),(m_protocol),local_addr(), remote_addr() }.to_string();
 		}
+		//udp only, outlet is sent as a run of segment_size datagrams (the last one might be shorter) by one syscall
+		//@note: it goes to the socket directly, the outbound handlers of the pipeline are not involved
+		NRP<promise<int>> ch_write_to_segmented(NRP<packet> const& outlet, NRP<address> const& to, u16_t segment_size) {
+			NRP<promise<int>> chp = make_ref<promise<int>>();
+			L->execute([S = NRP<socket_channel>(this), chp, outlet, to, segment_size]() {
+				S->__ch_write_to_impl(chp, outlet, to, segment_size);
+			});
+			return chp;
+		}
+
 		void ch_set_tx_limit(netp::u32_t limit) override {
 			L->execute([s = NRP<socket_channel>(this), limit]() {
 				s->m_tx_limit = (limit != 0 && limit< _NETP_SOCKET_CHANNEL_LIMIT_MIN) ? _NETP_SOCKET_CHANNEL_LIMIT_MIN: limit;
@@ -0,0 +1,125 @@
+#ifndef _NETP_TASK_HPP
+#define _NETP_TASK_HPP
+
+#include <type_traits>
+
+#include <netp/core.hpp>
+#include <netp/memory.hpp>
+
+//the accept lambda of socket_channel (a std::function and five NRPs) is the largest one on the common path
+#define NETP_TASK_INLINE_SIZE 80
+
+namespace netp {
+
+	//@note: move only void() callable of the loop queue
+	//a callable of at most NETP_TASK_INLINE_SIZE bytes with a nothrow move ctor is stored inline, a larger one is made by netp::allocator
+	class task final {
+		NETP_DECLARE_NONCOPYABLE(task)
+
+		typedef typename std::aligned_storage<NETP_TASK_INLINE_SIZE, alignof(std::max_align_t)>::type storage_t;
+
+		struct ops {
+			void (*invoke)(storage_t& s);
+			void (*move)(storage_t& dst, storage_t& src); //src is left to be destroyed
+			void (*destroy)(storage_t& s);
+		};
+
+		template <class _Fn>
+		struct inline_ops {
+			static void invoke(storage_t& s) { (*reinterpret_cast<_Fn*>(&s))(); }
+			static void move(storage_t& dst, storage_t& src) { ::new ((void*)&dst) _Fn(std::move(*reinterpret_cast<_Fn*>(&src))); }
+			static void destroy(storage_t& s) { reinterpret_cast<_Fn*>(&s)->~_Fn(); }
+			static const ops* get() {
+				static const ops _ops = { &invoke, &move, &destroy };
+				return &_ops;
+			}
+		};
+
+		template <class _Fn>
+		struct heap_ops {
+			static void invoke(storage_t& s) { (**reinterpret_cast<_Fn**>(&s))(); }
+			static void move(storage_t& dst, storage_t& src) { *reinterpret_cast<_Fn**>(&dst) = *reinterpret_cast<_Fn**>(&src); *reinterpret_cast<_Fn**>(&src) = nullptr; }
+			static void destroy(storage_t& s) { netp::allocator<_Fn>::trash(*reinterpret_cast<_Fn**>(&s)); }
+			static const ops* get() {
+				static const ops _ops = { &invoke, &move, &destroy };
+				return &_ops;
+			}
+		};
+
+		template <class _Fn>
+		struct is_inline :
+			std::integral_constant<bool, (sizeof(_Fn) <= sizeof(storage_t)) && (alignof(storage_t) % alignof(_Fn) == 0) && std::is_nothrow_move_constructible<_Fn>::value>
+		{};
+
+		storage_t m_storage;
+		const ops* m_ops;
+
+		template <class _Fn>
+		inline void _make(_Fn&& fn, std::true_type) {
+			typedef typename std::decay<_Fn>::type fn_t;
+			::new ((void*)&m_storage) fn_t(std::forward<_Fn>(fn));
+			m_ops = inline_ops<fn_t>::get();
+		}
+
+		template <class _Fn>
+		inline void _make(_Fn&& fn, std::false_type) {
+			typedef typename std::decay<_Fn>::type fn_t;
+			fn_t* p = netp::allocator<fn_t>::make(std::forward<_Fn>(fn));
+			NETP_ALLOC_CHECK(p, sizeof(fn_t));
+			*reinterpret_cast<fn_t**>(&m_storage) = p;
+			m_ops = heap_ops<fn_t>::get();
+		}
+
+		inline void _reset() {
+			if (m_ops != nullptr) {
+				m_ops->destroy(m_storage);
+				m_ops = nullptr;
+			}
+		}
+
+	public:
+		task() : m_ops(nullptr) {}
+		task(std::nullptr_t) : m_ops(nullptr) {}
+
+		template <class _Fn, class = typename std::enable_if<!std::is_same<typename std::decay<_Fn>::type, task>::value>::type>
+		task(_Fn&& fn) : m_ops(nullptr) {
+			_make(std::forward<_Fn>(fn), is_inline<typename std::decay<_Fn>::type>());
+		}
+
+		task(task&& other) : m_ops(other.m_ops) {
+			if (m_ops != nullptr) {
+				m_ops->move(m_storage, other.m_storage);
+				other._reset();
+			}
+		}
+
+		~task() {
+			_reset();
+		}
+
+		task& operator=(task&& other) {
+			if (this != &other) {
+				_reset();
+				if (other.m_ops != nullptr) {
+					m_ops = other.m_ops;
+					m_ops->move(m_storage, other.m_storage);
+					other._reset();
+				}
+			}
+			return *this;
+		}
+
+		task& operator=(std::nullptr_t) {
+			_reset();
+			return *this;
+		}
+
+		inline explicit operator bool() const { return m_ops != nullptr; }
+
+		inline void operator()() {
+			NETP_ASSERT(m_ops != nullptr);
+			m_ops->invoke(m_storage);
+		}
+	};
+}
+#endif
@@ -0,0 +1,130 @@
+#ifndef _NETP_TCP_INFO_SAMPLER_HPP
+#define _NETP_TCP_INFO_SAMPLER_HPP
+
+#include <vector>
+
+#include <netp/core.hpp>
+#include <netp/smart_ptr.hpp>
+#include <netp/mutex.hpp>
+#include <netp/histogram.hpp>
+#include <netp/timer.hpp>
+#include <netp/event_loop.hpp>
+#include <netp/socket_channel.hpp>
+
+namespace netp {
+
+	struct tcp_info_histograms {
+		histogram rtt_us;
+		histogram rttvar_us;
+		histogram snd_cwnd;
+		histogram retrans; //segments retransmitted since the previous sample
+		histogram unacked;
+		histogram pacing_rate;
+		histogram delivery_rate;
+
+		void record(socket_tcp_info const& info, u32_t retrans_delta) {
+			rtt_us.record(info.rtt_us);
+			rttvar_us.record(info.rttvar_us);
+			snd_cwnd.record(info.snd_cwnd);
+			retrans.record(retrans_delta);
+			unacked.record(info.unacked);
+			pacing_rate.record(info.pacing_rate);
+			delivery_rate.record(info.delivery_rate);
+		}
+
+		void merge(tcp_info_histograms const& other) {
+			rtt_us.merge(other.rtt_us);
+			rttvar_us.merge(other.rttvar_us);
+			snd_cwnd.merge(other.snd_cwnd);
+			retrans.merge(other.retrans);
+			unacked.merge(other.unacked);
+			pacing_rate.merge(other.pacing_rate);
+			delivery_rate.merge(other.delivery_rate);
+		}
+
+		void reset() {
+			rtt_us.reset();
+			rttvar_us.reset();
+			snd_cwnd.reset();
+			retrans.reset();
+			unacked.reset();
+			pacing_rate.reset();
+			delivery_rate.reset();
+		}
+	};
+
+	//the per channel counterpart of tcp_info_histograms, a value_stat per field instead of a histogram, a few hundred bytes per channel
+	struct tcp_info_stat {
+		value_stat rtt_us;
+		value_stat rttvar_us;
+		value_stat snd_cwnd;
+		value_stat retrans; //segments retransmitted since the previous sample
+		value_stat unacked;
+		value_stat pacing_rate;
+		value_stat delivery_rate;
+
+		void record(socket_tcp_info const& info, u32_t retrans_delta) {
+			rtt_us.record(info.rtt_us);
+			rttvar_us.record(info.rttvar_us);
+			snd_cwnd.record(info.snd_cwnd);
+			retrans.record(retrans_delta);
+			unacked.record(info.unacked);
+			pacing_rate.record(info.pacing_rate);
+			delivery_rate.record(info.delivery_rate);
+		}
+	};
+
+	//@note: periodic TCP_INFO sampler of the channels on one loop
+	//nothing is sampled unless a sampler is made and started, a started sampler costs one timer and one getsockopt per watched channel per tick
+	//every sample goes to the tcp_info_stat of its channel and to the aggregate histograms, a channel is dropped at the first tick after it is closed
+	//a tick reads TCP_INFO of all the channels first, then records them under m_mtx, a reader is never blocked by a getsockopt
+	//the pending timer holds a ref of the sampler till the first tick after stop()
+	class tcp_info_sampler final :
+		public netp::ref_base
+	{
+		struct sampled_channel final :
+			public netp::ref_base
+		{
+			NRP<socket_channel> ch;
+			u32_t total_retrans;
+			tcp_info_stat st;
+			//the sample of the current tick, L only
+			int rt;
+			socket_tcp_info info;
+		};
+		typedef std::vector<NRP<sampled_channel>> sampled_channel_vector_t;
+
+		NRP<event_loop> L;
+		timer_duration_t m_interval;
+		bool m_running;
+		bool m_tm_pending;
+
+		//guards m_channels, the stats and the aggregate for a reader out of L, m_channels is only changed on L
+		mutable spin_mutex m_mtx;
+		sampled_channel_vector_t m_channels;
+		tcp_info_histograms m_aggregate;
+
+		void _tmcb_sample(NRP<timer> const& t);
+		void _do_start();
+		void _do_stop();
+		void _do_watch(NRP<socket_channel> const& ch);
+		void _do_unwatch(NRP<socket_channel> const& ch);
+
+	public:
+		tcp_info_sampler(NRP<event_loop> const& L_, timer_duration_t const& interval);
+
+		void start();
+		void stop();
+
+		//ch must be a tcp channel of L, return E_INVALID_OPERATION if not
+		int watch(NRP<socket_channel> const& ch);
+		void unwatch(NRP<socket_channel> const& ch);
+
+		//thread safe, return false if ch is not (or no longer) watched
+		bool channel_snapshot(NRP<socket_channel> const& ch, tcp_info_stat& o) const;
+		//thread safe
+		void aggregate_snapshot(tcp_info_histograms& o) const;
+		void reset_aggregate();
+	};
+}
+#endif
@@ -160,12 +160,59 @@ namespace netp {
 	}
 	address::address()
 	{
+#ifdef NETP_ENABLE_AF_UNIX
+		std::memset((void*)&m_un, 0, sizeof(struct sockaddr_un));
+		m_un_len = 0;
+#else
 		std::memset((void*)&m_in,0,sizeof(sockaddr_in));
+#endif
 		m_in.sin_family = u16_t(NETP_AF_UNSPEC);
 		std::memset((void*)&m_in6, 0, sizeof(sockaddr_in6));
 		m_in6.sin6_family = u16_t(NETP_AF_UNSPEC);
 	}
 
+#ifdef NETP_ENABLE_AF_UNIX
+	address::address(const char* path, size_t len):
+		address()
+	{
+		NETP_ASSERT(path != nullptr && len > 0 && len < sizeof(m_un.sun_path));
+		m_un.sun_family = NETP_AF_UNIX;
+		std::memcpy(m_un.sun_path, path, len);
+#ifdef NETP_ENABLE_AF_UNIX_ABSTRACT
+		if (path[0] == '@') {
+			//@note: the abstract name is all the bytes given by the length, without a trailing '\0'
+			m_un.sun_path[0] = '\0';
+			m_un_len = socklen_t(offsetof(struct sockaddr_un, sun_path) + len);
+			return;
+		}
+#endif
+		m_un_len = socklen_t(offsetof(struct sockaddr_un, sun_path) + len + 1);
+	}
+
+	string_t address::unix_path() const {
+		NETP_ASSERT(is_unix());
+		if (is_unix_unnamed()) {
+			return string_t();
+		}
+		const size_t plen = m_un_len - offsetof(struct sockaddr_un, sun_path);
+		if (m_un.sun_path[0] == '\0') {
+			return string_t(m_un.sun_path + 1, plen - 1);
+		}
+		//the kernel reports the path with or without the trailing '\0'
+		return string_t(m_un.sun_path, ::strnlen(m_un.sun_path, plen));
+	}
+
+	u64_t address::__unix_hash() const {
+		//fnv-1a of the path, the length reported by the kernel might or might not count the trailing '\0'
+		u64_t h = is_unix_abstract() ? 1ULL : 14695981039346656037ULL;
+		const string_t path = unix_path();
+		for (size_t i = 0; i < path.length(); ++i) {
+			h = (h ^ u8_t(path[i])) * 1099511628211ULL;
+		}
+		return h;
+	}
+#endif
+
 	address::address( char const* ip, unsigned short port , int f)
 	{
 		NETP_ASSERT(f < 255);
@@ -203,6 +250,11 @@ namespace netp {
 	}
 
 	string_t address::to_string() const {
+#ifdef NETP_ENABLE_AF_UNIX
+		if (is_unix()) {
+			return (is_unix_abstract() ? string_t("@") : string_t()) + unix_path();
+		}
+#endif
 		char info[32] = { 0 };
 		int rtval = snprintf(const_cast<char*>(info), sizeof(info) / sizeof(info[0]), "%s:%d", dotip().c_str(), port());
 		NETP_ASSERT(rtval > 0);
@@ -70,6 +70,17 @@ namespace netp {
 		}
 	}
 
+	void app::cfg_poller(std::string const& poller) {
+#if defined(NETP_HAS_POLLER_IO_URING)
+		if (poller == "io_uring") {
+			m_poller_type = u8_t(io_poller_type::T_IO_URING);
+			return;
+		}
+#endif
+		(void)poller;
+		m_poller_type = u8_t(NETP_DEFAULT_POLLER_TYPE);
+	}
+
 	void app::cfg_channel_read_buf(u32_t buf_in_kbytes) {
 		if (buf_in_kbytes == 0) {
 			buf_in_kbytes = 128;
@@ -81,6 +92,25 @@ namespace netp {
 		m_channel_read_buf_size = buf_in_kbytes * (1024);
 	}
 
+	void app::cfg_loop_spin_us(u32_t spin_us) {
+		if (spin_us > 100000) {
+			spin_us = 100000;
+		}
+		m_loop_spin_us = spin_us;
+	}
+
+	void app::cfg_loop_select(std::string const& policy) {
+		if (policy == "least_io_ctx") {
+			m_loop_select_policy = u8_t(LSP_LEAST_IO_CTX);
+		} else if (policy == "least_busy") {
+			m_loop_select_policy = u8_t(LSP_LEAST_BUSY);
+		} else if (policy == "power_of_two") {
+			m_loop_select_policy = u8_t(LSP_POWER_OF_TWO);
+		} else {
+			m_loop_select_policy = u8_t(LSP_ROUND_ROBIN);
+		}
+	}
+
 	void app::cfg_channel_tx_limit_clock(u32_t clock) {
 		if (clock < 1) {
 			clock = 1;
@@ -186,12 +216,22 @@ namespace netp {
 			cfg_loop_count(cfg_json["netp_def_loop_count"]);
 		}
 
+		if (cfg_json.find("netp_poller") != cfg_json.end() && cfg_json["netp_poller"].is_string()) {
+			cfg_poller(cfg_json["netp_poller"].get<std::string>());
+		}
+
 		if (cfg_json.find("netp_channel_read_buf") != cfg_json.end() && cfg_json["netp_channel_read_buf"].is_number()) {
 			cfg_channel_read_buf(cfg_json["netp_channel_read_buf"].get<int>());
 		}
 		if (cfg_json.find("netp_channel_tx_limit_clock") != cfg_json.end() && cfg_json["netp_channel_tx_limit_clock"].is_number()) {
 			cfg_channel_tx_limit_clock(cfg_json["netp_channel_tx_limit_clock"].get<int>());
 		}
+		if (cfg_json.find("netp_loop_spin_us") != cfg_json.end() && cfg_json["netp_loop_spin_us"].is_number()) {
+			cfg_loop_spin_us(cfg_json["netp_loop_spin_us"].get<u32_t>());
+		}
+		if (cfg_json.find("netp_loop_select") != cfg_json.end() && cfg_json["netp_loop_select"].is_string()) {
+			cfg_loop_select(cfg_json["netp_loop_select"].get<std::string>());
+		}
 
 		return netp::OK;
 	}
@@ -207,6 +247,9 @@ namespace netp {
 			{"netp-def-loop-count", optional_argument, 0, 5 },
 			{"netp-channel-read-buf", optional_argument, 0, 6 },
 			{"netp-channel-bdlimit-clock", optional_argument, 0, 7 },
+			{"netp-poller", optional_argument, 0, 8 },
+			{"netp-loop-spin-us", optional_argument, 0, 9 },
+			{"netp-loop-select", optional_argument, 0, 10 },
 			{0,0,0,0}
 		};
 
@@ -278,6 +321,21 @@ namespace netp {
 				cfg_channel_tx_limit_clock(std::atoi(optarg));
 			}
 			break;
+			case 8:
+			{
+				cfg_poller(std::string(optarg));
+			}
+			break;
+			case 9:
+			{
+				cfg_loop_spin_us(u32_t(std::atoi(optarg)));
+			}
+			break;
+			case 10:
+			{
+				cfg_loop_select(std::string(optarg));
+			}
+			break;
 			}
 		}
 
@@ -305,8 +363,11 @@ namespace netp {
 
 	app::app() :
 		m_loop_count(u32_t(std::thread::hardware_concurrency())),
+		m_poller_type(u8_t(NETP_DEFAULT_POLLER_TYPE)),
 		m_channel_read_buf_size(128*1024),
 		m_channel_tx_limit_clock(30),/*resolution on windows is 15ms*/
+		m_loop_spin_us(0),
+		m_loop_select_policy(u8_t(LSP_ROUND_ROBIN)),
 		m_is_cfg_json_loaded(false),
 		m_should_exit(false), 
 		m_app_state(app_state::s_idle),
@@ -574,7 +635,9 @@ namespace netp {
 #endif
 
 		NETP_ASSERT(m_def_loop_group == nullptr);
-		event_loop_cfg cfg(NETP_DEFAULT_POLLER_TYPE, u8_t(f_enable_dns_resolver), m_channel_read_buf_size);
+		event_loop_cfg cfg(m_poller_type, u8_t(f_enable_dns_resolver), m_channel_read_buf_size);
+		cfg.spin_us = m_loop_spin_us;
+		cfg.select_policy = m_loop_select_policy;
 		dns_hosts(cfg.dns_hosts);
 		m_def_loop_group = netp::make_ref<netp::event_loop_group>(cfg, default_event_loop_maker);
 		NETP_TRACE_APP("net init end");
@@ -49,6 +49,7 @@ namespace netp {
 	VOID_FIRE_HANDLER_DEFAULT_IMPL_INT_1(error, CH_ACTIVITY_ERROR, channel_handler_abstract)
 	VOID_FIRE_HANDLER_DEFAULT_IMPL_0(read_closed, CH_ACTIVITY_READ_CLOSED, channel_handler_abstract)
 	VOID_FIRE_HANDLER_DEFAULT_IMPL_0(write_closed, CH_ACTIVITY_WRITE_CLOSED, channel_handler_abstract)
+	VOID_FIRE_HANDLER_DEFAULT_IMPL_0(writability_changed, CH_ACTIVITY_WRITABILITY_CHANGED, channel_handler_abstract)
 	
 	//VOID_FIRE_HANDLER_DEFAULT_IMPL_0(write_block, CH_ACTIVITY_WRITE_BLOCK, channel_handler_abstract)
 	//VOID_FIRE_HANDLER_DEFAULT_IMPL_0(write_unblock, CH_ACTIVITY_WRITE_UNBLOCK, channel_handler_abstract)
@@ -95,6 +96,10 @@ namespace netp {
 		ctx->ch->ch_write_impl(intp,outlet);
 	}
 
+	void channel_handler_head::flush(NRP<channel_handler_context> const& ctx) {
+		ctx->ch->ch_flush_impl();
+	}
+
 	void channel_handler_head::close(NRP<promise<int>> const& intp, NRP<channel_handler_context> const& ctx) {
 		ctx->ch->ch_close_impl(intp);
 	}
@@ -138,6 +143,10 @@ namespace netp {
 		ctx->ch->ch_close_read();
 		(void)ctx;
 	}
+	void channel_handler_tail::writability_changed(NRP<channel_handler_context> const& ctx) {
+		NETP_TRACE_CHANNEL("[#%s][tail]channel writability changed, no action", ctx->ch->ch_info().c_str());
+		(void)ctx;
+	}
 
 	void channel_handler_tail::read(NRP<channel_handler_context> const& ctx, NRP<packet> const& income) {
 		//NETP_ASSERT(ctx->ch != nullptr);
@@ -22,6 +22,10 @@
 #error "unknown poller type"
 #endif
 
+#if defined(NETP_HAS_POLLER_IO_URING)
+#include <netp/poller_io_uring.hpp>
+#endif
+
 namespace netp {
 
 	NRP<event_loop> default_event_loop_maker(event_loop_cfg const& cfg) {
@@ -61,6 +65,22 @@ namespace netp {
 			NETP_ALLOC_CHECK(poller, sizeof(poller_select));
 		}
 		break;
+#endif
+#if defined(NETP_HAS_POLLER_IO_URING)
+		case T_IO_URING:
+		{
+			NRP<poller_io_uring> uring = netp::make_ref<poller_io_uring>();
+			NETP_ALLOC_CHECK(uring, sizeof(poller_io_uring));
+			const int rt = uring->setup();
+			if (rt != netp::OK) {
+				NETP_WARN("[event_loop]io_uring not available: %d, fallback to the default poller", rt);
+				event_loop_cfg _cfg = cfg;
+				_cfg.type = u8_t(NETP_DEFAULT_POLLER_TYPE);
+				return default_event_loop_maker(_cfg);
+			}
+			poller = uring;
+		}
+		break;
 #endif
 		default:
 		{
@@ -75,12 +95,14 @@ namespace netp {
 	void event_loop::init() {
 		NETP_ASSERT(m_cfg.channel_read_buf_size > 0);
 		m_channel_rcv_buf = netp::make_ref<netp::packet>(m_cfg.channel_read_buf_size);
+		m_channel_rcv_batch_buf.resize(NETP_SOCKET_RCV_BATCH_MAX);
+		m_channel_rcv_batch_addr.resize(NETP_SOCKET_RCV_BATCH_MAX);
 		m_tid = std::this_thread::get_id();
 		m_tb = netp::make_ref<timer_broker>();
 		m_poller->init();
 
 		if (m_cfg.flag & f_enable_dns_resolver) {
-			if (m_cfg.type == NETP_DEFAULT_POLLER_TYPE) {
+			if (NETP_IS_SOCKET_POLLER_TYPE(m_cfg.type)) {
 				m_dns_resolver = netp::make_ref<dns_resolver>(NRP<event_loop>(this));
 				inc_internal_ref_count();
 			} else {
@@ -111,19 +133,59 @@ namespace netp {
 			m_dns_resolver = nullptr;
 		}
 
-		{
-			lock_guard<spin_mutex> lg(m_tq_mutex);
-			NETP_ASSERT(m_tq_standby.empty());
-		}
-
 		NETP_ASSERT(m_tq.empty());
 		NETP_ASSERT(m_tb->size() == 0);
 		m_tb = nullptr;
 
+		m_channel_rcv_spare = nullptr;
+		m_channel_rcv_batch_buf.clear();
+		m_channel_rcv_batch_addr.clear();
+
 		m_poller->deinit();
 		NETP_VERBOSE("[event_loop][%p]deinit done", this );
 	}
 
+	void event_loop::__poll_stat_update(i64_t wait_in_nano, int nevents, bool has_task, i64_t now_ns) {
+		if (m_spinning) {
+			m_spinning = false;
+			__stat_incre(m_stat_spin_polls);
+			if (nevents > 0) {
+				__stat_incre(m_stat_spin_hits);
+			}
+		} else if (wait_in_nano != 0) {
+			__stat_incre(m_stat_sleep_polls);
+			if (nevents > 0) {
+				__stat_incre(m_stat_sleep_hits);
+			}
+		}
+
+		//any activity restarts the spin budget
+		if ((m_cfg.spin_us != 0) && ((nevents > 0) || has_task)) {
+			m_spin_until = now_ns + i64_t(m_cfg.spin_us) * 1000LL;
+		}
+	}
+
+	//an exponential moving average weighted by the wall time of the iteration
+	void event_loop::__busy_ratio_update(i64_t iteration_ns, i64_t wait_ns) {
+		if (iteration_ns <= 0) {
+			return;
+		}
+		const i64_t busy_ns = wait_ns < iteration_ns ? (iteration_ns - wait_ns) : 0;
+		const double w = iteration_ns < NETP_LOOP_BUSY_WINDOW_NS ? double(iteration_ns) / double(NETP_LOOP_BUSY_WINDOW_NS) : 1.0;
+		m_busy_avg += ((double(busy_ns) / double(iteration_ns)) - m_busy_avg) * w;
+		m_busy_ratio.store(u32_t(m_busy_avg * 65536.0), std::memory_order_relaxed);
+	}
+
+	void event_loop::latency_snapshot(event_loop_latency_stat& o) const {
+		o.wakeups = m_stat_wakeups.load(std::memory_order_relaxed);
+		m_lat_task_ns.snapshot(o.task_ns);
+		m_lat_task_depth.snapshot(o.task_depth);
+		m_lat_timer_ns.snapshot(o.timer_ns);
+		m_lat_poll_ns.snapshot(o.poll_ns);
+		m_lat_io_ns.snapshot(o.io_ns);
+		m_lat_ready_events.snapshot(o.ready_events);
+	}
+
 	//@NOTE: promise to execute all task already in tq or tq_standby
 	void event_loop::__run() {
 
@@ -141,47 +203,43 @@ namespace netp {
 		//NETP_ASSERT(!"CHECK EXCEPTION STACK");
 		init();
 		//record a snapshot, used by update state
-		m_io_ctx_count_before_running = m_io_ctx_count;
+		m_io_ctx_count_before_running = m_io_ctx_count.load(std::memory_order_relaxed);
 		u8_t _SL = u8_t(loop_state::S_LAUNCHING);
 		const bool rt = m_state.compare_exchange_strong(_SL, u8_t(loop_state::S_RUNNING), std::memory_order_acq_rel, std::memory_order_acquire);
 		NETP_ASSERT(rt == true);
-#ifdef NETP_DEBUG_LOOP_TIME
-		m_loop_last_tp = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
-#endif
 		try {
+			//four clock reads an iteration, the end of one iteration is the begin of the next one
+			i64_t tp_begin = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
 			//this load also act as a memory synchronization fence to sure all release operation happen before this line
 			//if we make_ref a atomic_ref object, then we call L->schedule([o=atomic_ref_instance](){});, the assign of a atomic_ref_instance would trigger memory_order_acq_rel, this operation guard all object member initialization and member valud update before the assign
 			//all member value of that object must be synchronized after this line, cuz we have netp::atomic_incre inside ref object
 			while (NETP_UNLIKELY(u8_t(loop_state::S_EXIT) != m_state.load(std::memory_order_acquire))) {
-				{
-					//again the spin_mutex acts as a memory synchronization fence
-					lock_guard<spin_mutex> lg(m_tq_mutex);
-					if (!m_tq_standby.empty()) {
-						m_tq.swap(m_tq_standby);
-					}
-				}
-				const std::size_t ss = m_tq.size();
+				const std::size_t ss = m_tq.consume([](task& t) {
+					t();
+				});
+				const i64_t tp_task = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
 				if (ss > 0) {
-					std::size_t i = 0;
-					while (i < ss) {
-						m_tq[i++]();
-					}
-					NETP_ASSERT(ss == m_tq.size());
-					
-					if (m_tq.capacity()>512) {
-						io_task_q_t().swap(m_tq);
-					} else {
-						m_tq.clear();
-					}
+					m_lat_task_ns.record(u64_t(tp_task - tp_begin));
+					m_lat_task_depth.record(u64_t(ss));
 				}
-				//@_calc_wait_dur_in_nano must happen before poll..
 
-#ifdef NETP_DEBUG_LOOP_TIME
-				long long _now = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
-				NETP_INFO("[event_loop]loop dt: %llu ns, last_wait: %llu", _now - m_loop_last_tp, m_last_wait);
-				m_loop_last_tp = _now;
-#endif
-				m_poller->poll(_calc_wait_dur_in_nano(), m_waiting);
+				netp::timer_duration_t ndelay;
+				m_tb->expire(ndelay);
+				const i64_t tp_timer = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
+				m_lat_timer_ns.record(u64_t(tp_timer - tp_task));
+
+				//@_calc_wait_dur_in_nano must happen before poll..
+				const i64_t wt = _calc_wait_dur_in_nano(i64_t(ndelay.count()), tp_timer);
+				m_poll_begin_ns.store(tp_timer, std::memory_order_relaxed);
+				const int nevents = m_poller->poll(wt, m_waiting);
+				const i64_t tp_end = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
+				const i64_t tp_wait_exit = m_poller->wait_exit_ns();
+				m_lat_poll_ns.record(u64_t(tp_wait_exit - tp_timer));
+				m_lat_io_ns.record(u64_t(tp_end - tp_wait_exit));
+				m_lat_ready_events.record(u64_t(nevents));
+				__poll_stat_update(wt, nevents, ss > 0, tp_end);
+				__busy_ratio_update(tp_end - tp_begin, tp_wait_exit - tp_timer);
+				tp_begin = tp_end;
 			}
 		}
 		catch (...) {
@@ -195,12 +253,13 @@ namespace netp {
 			// EDGE check
 			// scenario 1:
 			// 1) do schedule, 2) set L -> null
-			std::size_t i = 0;
-			std::size_t vecs = m_tq_standby.size();
-			while (i < vecs) {
-				m_tq_standby[i++]();
+			//a cell might be published a bit later than its claim, empty() waits for it
+			task t;
+			while (!m_tq.empty()) {
+				if (m_tq.pop(t)) {
+					t();
+				}
 			}
-			m_tq_standby.clear();
 			m_tb->expire_all();
 		}
 
@@ -221,7 +280,7 @@ namespace netp {
 		}
 
 		io_do(io_action::NOTIFY_TERMINATING, 0);
-		if (m_io_ctx_count == m_io_ctx_count_before_running) {
+		if (m_io_ctx_count.load(std::memory_order_relaxed) == m_io_ctx_count_before_running) {
 			__do_enter_terminated();
 		}
 	}
@@ -229,7 +288,7 @@ namespace netp {
 	void event_loop::__do_enter_terminated() {
 		//no competitor here, store directly
 		NETP_ASSERT(in_event_loop());
-		NETP_ASSERT(m_io_ctx_count == m_io_ctx_count_before_running);
+		NETP_ASSERT(m_io_ctx_count.load(std::memory_order_relaxed) == m_io_ctx_count_before_running);
 		u8_t terminating = u8_t(loop_state::S_TERMINATING);
 		if (m_state.compare_exchange_strong(terminating, u8_t(loop_state::S_TERMINATED), std::memory_order_acq_rel, std::memory_order_acquire)) {
 			NETP_VERBOSE("[event_loop][%p][%u]__do_enter_terminated done", this, m_cfg.type);
@@ -290,6 +349,17 @@ namespace netp {
 		m_io_ctx_count(0),
 		m_io_ctx_count_before_running(0), 
 		m_internal_ref_count(0),
+		m_poll_begin_ns(0),
+		m_busy_ratio(0),
+		m_busy_avg(0),
+		m_spin_until(0),
+		m_spinning(false),
+		m_stat_spin_polls(0),
+		m_stat_spin_hits(0),
+		m_stat_sleep_polls(0),
+		m_stat_sleep_hits(0),
+		m_stat_wakeups(0),
+		m_tq(NETP_LOOP_TASK_QUEUE_SIZE),
 		m_cfg(cfg),
 		m_dns_hosts(cfg.dns_hosts.begin(), cfg.dns_hosts.end())
 	{
@@ -305,11 +375,21 @@ namespace netp {
 
 	event_loop_group::event_loop_group( event_loop_cfg const& cfg, fn_event_loop_maker_t const& L_maker):
 		m_curr_loop_idx(0),
+		m_snapshot(nullptr),
+		m_select_policy(cfg.select_policy < LSP_MAX ? cfg.select_policy : u8_t(LSP_ROUND_ROBIN)),
+		m_reader_epoch(0),
 		m_bye_state(bye_event_loop_state::S_IDLE),
 		m_bye_ref_count(0),
 		m_cfg(cfg),
 		m_fn_loop_maker(L_maker)
 	{
+		event_loop_snapshot* s = netp::allocator<event_loop_snapshot>::make();
+		NETP_ALLOC_CHECK(s, sizeof(event_loop_snapshot));
+		m_snapshot.store(s, std::memory_order_release);
+		for (u32_t i = 0; i < NETP_LOOP_GROUP_READER_SLOTS; ++i) {
+			m_reader_slots[i].n[0].store(0, std::memory_order_relaxed);
+			m_reader_slots[i].n[1].store(0, std::memory_order_relaxed);
+		}
 	}
 
 	event_loop_group::~event_loop_group()
@@ -321,6 +401,77 @@ namespace netp {
 			m_bye_ref_count = 0;
 		}
 		NETP_ASSERT(m_bye_event_loop == nullptr);
+
+		netp::allocator<event_loop_snapshot>::trash(m_snapshot.load(std::memory_order_acquire));
+	}
+
+	//m_loop_mtx must be held by the caller, return the replaced one, it is to be passed to _trash_snapshot
+	event_loop_snapshot* event_loop_group::_publish_snapshot() {
+		event_loop_snapshot* s = netp::allocator<event_loop_snapshot>::make();
+		NETP_ALLOC_CHECK(s, sizeof(event_loop_snapshot));
+		s->L = m_loop;
+		for (std::size_t i = 0; i < s->L.size(); ++i) {
+			s->L[i]->inc_internal_ref_count();
+		}
+		return m_snapshot.exchange(s, std::memory_order_seq_cst);
+	}
+
+	//m_loop_mtx must be held by the caller, s must have been replaced
+	void event_loop_group::_trash_snapshot(event_loop_snapshot* s) {
+		_wait_readers();
+		for (std::size_t i = 0; i < s->L.size(); ++i) {
+			s->L[i]->dec_internal_ref_count();
+		}
+		netp::allocator<event_loop_snapshot>::trash(s);
+	}
+
+	static std::atomic<u32_t> __loop_reader_slot_next(0);
+	static __NETP_TLS u32_t __tls_loop_reader_slot = u32_t(-1);
+
+	//return the counter to leave, the snapshot is to be loaded after it
+	//the epoch is written by a detach only, its line stays shared, the counter is on the line of the slot of this thread
+	std::atomic<u32_t>* event_loop_group::_read_enter() {
+		u32_t idx = __tls_loop_reader_slot;
+		if (NETP_UNLIKELY(idx == u32_t(-1))) {
+			idx = __loop_reader_slot_next.fetch_add(1, std::memory_order_relaxed) % NETP_LOOP_GROUP_READER_SLOTS;
+			__tls_loop_reader_slot = idx;
+		}
+		event_loop_reader_slot& slot = m_reader_slots[idx];
+		while (1) {
+			const u32_t e = m_reader_epoch.load(std::memory_order_acquire);
+			slot.n[e & 1].fetch_add(1, std::memory_order_seq_cst);
+			//pairs with the flip of _wait_readers, either it sees this count or this load sees the flip, and the new snapshot with it
+			if (NETP_LIKELY(m_reader_epoch.load(std::memory_order_seq_cst) == e)) {
+				return &slot.n[e & 1];
+			}
+			slot.n[e & 1].fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	void event_loop_group::_read_leave(std::atomic<u32_t>* n) {
+		n->fetch_sub(1, std::memory_order_release);
+	}
+
+	//m_loop_mtx must be held by the caller, call it after _publish_snapshot
+	//a reader entered after the flip sees the new snapshot, the ones before it are waited
+	void event_loop_group::_wait_readers() {
+		const u32_t e = m_reader_epoch.fetch_add(1, std::memory_order_seq_cst);
+		for (u32_t i = 0; i < NETP_LOOP_GROUP_READER_SLOTS; ++i) {
+			while (m_reader_slots[i].n[e & 1].load(std::memory_order_seq_cst) != 0) {
+				netp::this_thread::no_interrupt_yield();
+			}
+		}
+	}
+
+	//m_bye_event_loop is assigned before S_RUNNING is stored, and it is not changed till the group is destroyed
+	NRP<event_loop> event_loop_group::_bye_loop() {
+		const bye_event_loop_state bs = m_bye_state.load(std::memory_order_acquire);
+		if (bs == bye_event_loop_state::S_RUNNING || bs == bye_event_loop_state::S_EXIT) {
+			NETP_ASSERT(m_bye_event_loop != nullptr, "m_bye_event_loop check");
+			NETP_VERBOSE("[event_loop][%u]return bye type", m_cfg.type);
+			return m_bye_event_loop;
+		}
+		NETP_THROW("event_loop_group deinit logic issue");
 	}
 
 	void event_loop_group::notify_terminating() {
@@ -381,10 +532,17 @@ namespace netp {
 			while (it != m_loop.end()) {
 				//ref_count == internal_ref_count means no other ref for this LOOP, it is safe to deattach it from our pool
 				if ((*it).ref_count() == (*it)->internal_ref_count()) {
-					NETP_VERBOSE("[event_loop][%u]_wait_loop, dattached one event loop", m_cfg.type);
-
-					to_deattach.push_back(*it);
+					NRP<event_loop> L = *it;
 					m_loop.erase(it);
+					_trash_snapshot(_publish_snapshot());
+					//a reader of the old snapshot might have copied L after the check above, put it back and try later
+					if (L.ref_count() != L->internal_ref_count()) {
+						m_loop.push_back(L);
+						_trash_snapshot(_publish_snapshot());
+						break;
+					}
+					NETP_VERBOSE("[event_loop][%u]_wait_loop, dattached one event loop", m_cfg.type);
+					to_deattach.push_back(std::move(L));
 					break;
 				} else {
 					++it;
@@ -437,6 +595,7 @@ namespace netp {
 				o->store_internal_ref_count(o.ref_count());
 				m_loop.emplace_back(std::move(o));
 			}
+			_trash_snapshot(_publish_snapshot());
 		}
 
 		void event_loop_group::stop() {
@@ -445,64 +604,179 @@ namespace netp {
 		}
 
 		netp::size_t event_loop_group::size() {
-			shared_lock_guard<shared_mutex> lg(m_loop_mtx);
-			return netp::size_t(m_loop.size());
+			std::atomic<u32_t>* n = _read_enter();
+			const netp::size_t size = netp::size_t(m_snapshot.load(std::memory_order_acquire)->L.size());
+			_read_leave(n);
+			return size;
+		}
+
+		event_loop_vector_t event_loop_group::loops() {
+			std::atomic<u32_t>* n = _read_enter();
+			event_loop_vector_t L = m_snapshot.load(std::memory_order_acquire)->L;
+			_read_leave(n);
+			return L;
+		}
+
+		void event_loop_group::set_select_policy(u8_t policy) {
+			NETP_ASSERT(policy < LSP_MAX);
+			m_select_policy.store(policy, std::memory_order_relaxed);
+		}
+
+		static __NETP_TLS u32_t __tls_loop_select_rnd = 0;
+		//xorshift32, seeded by the thread id at the first call of a thread
+		__NETP_FORCE_INLINE static u32_t __loop_select_rnd() {
+			u32_t x = __tls_loop_select_rnd;
+			if (NETP_UNLIKELY(x == 0)) {
+				x = u32_t(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+			}
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			__tls_loop_select_rnd = x;
+			return x;
+		}
+
+		__NETP_FORCE_INLINE static bool __loop_excluded(std::set<NRP<event_loop>> const* exclude, NRP<event_loop> const& L) {
+			return exclude != nullptr && exclude->find(L) != exclude->end();
+		}
+
+		//the first one from idx on that is neither skip nor excluded, skip if there is none
+		static u32_t __loop_allowed_from(event_loop_vector_t const& L, std::set<NRP<event_loop>> const* exclude, u32_t idx, u32_t skip) {
+			const u32_t n = u32_t(L.size());
+			for (u32_t i = 0; i < n; ++i) {
+				const u32_t j = (idx + i) % n;
+				if (j != skip && !__loop_excluded(exclude, L[j])) {
+					return j;
+				}
+			}
+			return skip;
+		}
+
+		//L is not empty, the loops in exclude are skipped, at least one of L must be left
+		u32_t event_loop_group::_select(event_loop_vector_t const& L, std::set<NRP<event_loop>> const* exclude) {
+			const u32_t n = u32_t(L.size());
+			if (n == 1) {
+				return 0;
+			}
+			switch (m_select_policy.load(std::memory_order_relaxed)) {
+			case LSP_LEAST_IO_CTX:
+			{
+				const u32_t from = __loop_allowed_from(L, exclude, __loop_select_rnd() % n, n);
+				u32_t idx = from;
+				int least = L[from]->io_ctx_count();
+				for (u32_t i = 1; i < n; ++i) {
+					const u32_t j = (from + i) % n;
+					if (__loop_excluded(exclude, L[j])) {
+						continue;
+					}
+					const int c = L[j]->io_ctx_count();
+					if (c < least) {
+						least = c;
+						idx = j;
+					}
+				}
+				return idx;
+			}
+			case LSP_LEAST_BUSY:
+			{
+				const i64_t now_ns = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
+				const u32_t from = __loop_allowed_from(L, exclude, __loop_select_rnd() % n, n);
+				u32_t idx = from;
+				u32_t least = L[from]->busy_ratio(now_ns);
+				for (u32_t i = 1; i < n; ++i) {
+					const u32_t j = (from + i) % n;
+					if (__loop_excluded(exclude, L[j])) {
+						continue;
+					}
+					const u32_t b = L[j]->busy_ratio(now_ns);
+					if (b < least) {
+						least = b;
+						idx = j;
+					}
+				}
+				return idx;
+			}
+			case LSP_POWER_OF_TWO:
+			{
+				const u32_t r = __loop_select_rnd();
+				const u32_t a = __loop_allowed_from(L, exclude, r % n, n);
+				u32_t b = (r >> 16) % (n - 1);
+				if (b >= a) {
+					++b;
+				}
+				b = __loop_allowed_from(L, exclude, b, a);
+				if (b == a) {
+					return a;
+				}
+				const int ca = L[a]->io_ctx_count();
+				const int cb = L[b]->io_ctx_count();
+				if (ca != cb) {
+					return ca < cb ? a : b;
+				}
+				const i64_t now_ns = netp::now<std::chrono::nanoseconds, netp::steady_clock_t>().time_since_epoch().count();
+				return L[a]->busy_ratio(now_ns) <= L[b]->busy_ratio(now_ns) ? a : b;
+			}
+			default:
+			{
+				return __loop_allowed_from(L, exclude, m_curr_loop_idx.fetch_add(1, std::memory_order_relaxed) % n, n);
+			}
+			}
+		}
+
+		void event_loop_group::latency_snapshot(event_loop_latency_stat& o) {
+			o.reset();
+			event_loop_vector_t L = loops();
+			event_loop_latency_stat ls;
+			for (std::size_t i = 0; i < L.size(); ++i) {
+				L[i]->latency_snapshot(ls);
+				o.merge(ls);
+			}
 		}
 
 		//if there is a event_loop_group instance, we must always guarantee to return non-null loop instance
+		//the loops of the set are skipped if any other is left, round robin over all of them otherwise
 		NRP<event_loop> event_loop_group::next(std::set<NRP<event_loop>> const& exclude_this_list_if_have_more) {
 			{
-				shared_lock_guard<shared_mutex> lg(m_loop_mtx);
-				if (m_loop.size() > 0) {
-					const std::size_t psize = m_loop.size();
-					if (psize <= exclude_this_list_if_have_more.size()) {
-						//skip one time
-						//u32_t idx = netp::atomic_incre(&m_curr_poller_idx[t]) % psize;
-						//if (exclude_this_list_if_have_more.find(pollers[idx]) == exclude_this_list_if_have_more.end()) {
-						//	return pollers[idx];
-						//}
-						return m_loop[m_curr_loop_idx.fetch_add(1, std::memory_order_relaxed) % psize];
+				std::atomic<u32_t>* n = _read_enter();
+				event_loop_vector_t const& L = m_snapshot.load(std::memory_order_acquire)->L;
+				if (L.size() > 0) {
+					NRP<event_loop> __tmp;
+					bool left = false;
+					for (std::size_t i = 0; i < L.size() && !left; ++i) {
+						left = !__loop_excluded(&exclude_this_list_if_have_more, L[i]);
 					}
-					else {
-						u32_t idx = m_curr_loop_idx.fetch_add(1, std::memory_order_relaxed) % psize;
-						while (exclude_this_list_if_have_more.find(m_loop[idx]) != exclude_this_list_if_have_more.end()) {
-							idx = m_curr_loop_idx.fetch_add(1, std::memory_order_relaxed) % psize;
-						}
-						return m_loop[idx];
+					if (!left) {
+						__tmp = L[m_curr_loop_idx.fetch_add(1, std::memory_order_relaxed) % L.size()];
+					} else {
+						__tmp = L[_select(L, &exclude_this_list_if_have_more)];
 					}
+					_read_leave(n);
+					return __tmp;
 				}
+				_read_leave(n);
 			}
-			//as the load might happens on other thread, we need a memory barrier
-			NRP<event_loop> __tmp = m_bye_event_loop;//may a copy first
-			if (m_bye_state.load(std::memory_order_acquire) != bye_event_loop_state::S_IDLE) {
-				NETP_ASSERT(__tmp != nullptr);
-				NETP_VERBOSE("[event_loop][%u]return bye type", m_cfg.type);
-				return __tmp;
-			}
-			NETP_THROW("event_loop_group deinit logic issue");
+			return _bye_loop();
 		}
 
 		NRP<event_loop> event_loop_group::next() {
 			{
-				shared_lock_guard<shared_mutex> lg(m_loop_mtx);
-				if (m_loop.size() != 0) {
-					return m_loop[m_curr_loop_idx.fetch_add(1, std::memory_order_relaxed) % m_loop.size()];
+				std::atomic<u32_t>* n = _read_enter();
+				event_loop_vector_t const& L = m_snapshot.load(std::memory_order_acquire)->L;
+				if (L.size() != 0) {
+					NRP<event_loop> __tmp = L[_select(L, nullptr)];
+					_read_leave(n);
+					return __tmp;
 				}
+				_read_leave(n);
 			}
-			NRP<event_loop> __tmp = m_bye_event_loop;//may a copy first
-			if(m_bye_state.load(std::memory_order_acquire) != bye_event_loop_state::S_IDLE) {
-				NETP_ASSERT(__tmp != nullptr, "m_bye_event_loop check");
-				NETP_VERBOSE("[event_loop][%u]return bye type", m_cfg.type);
-				return __tmp;
-			}
-			NETP_THROW("event_loop_group deinit logic issue");
+			return _bye_loop();
 		}
 
-		void event_loop_group::execute(fn_task_t&& f) {
-			next()->execute(std::forward<fn_task_t>(f));
+		void event_loop_group::execute(task&& f) {
+			next()->execute(std::move(f));
 		}
-		void event_loop_group::schedule(fn_task_t&& f) {
-			next()->schedule(std::forward<fn_task_t>(f));
+		void event_loop_group::schedule(task&& f) {
+			next()->schedule(std::move(f));
 		}
 		void event_loop_group::launch(NRP<netp::timer> const& t, NRP<netp::promise<int>> const& lf) {
 			next()->launch(t,lf);
@@ -0,0 +1,355 @@
+#include <netp/core.hpp>
+#include <netp/mutex.hpp>
+#include <netp/condition.hpp>
+#include <netp/thread.hpp>
+#include <netp/logger_broker.hpp>
+
+#include <netp/executor.hpp>
+
+namespace netp {
+
+	//spin rounds before a worker parks, a task executed right after a worker runs out of work is picked up without a wakeup
+	#define NETP_EXECUTOR_SPIN_ROUND 32
+
+	//task cells kept by a worker for reuse, the cells of the tasks stolen from the others end up here too
+	#define NETP_EXECUTOR_CELL_CACHE 256
+
+	struct executor::worker {
+		NETP_DECLARE_NONCOPYABLE(worker)
+	public:
+		executor* E;
+		u32_t id;
+		u32_t rnd;
+		NRP<netp::thread> th;
+		ws_deque dq[EP_MAX];
+		std::vector<task*> cells; //worker thread only
+
+		netp::mutex mtx;
+		netp::condition_variable cond;
+		std::atomic<bool> sleeping;
+		bool notified;
+
+		std::atomic<u64_t> executed;
+		std::atomic<u64_t> stolen;
+		std::atomic<u64_t> parks;
+
+		worker(executor* E_, u32_t id_) :
+			E(E_),
+			id(id_),
+			rnd(id_ * 2654435761u + 1),
+			sleeping(false),
+			notified(false),
+			executed(0),
+			stolen(0),
+			parks(0)
+		{
+			cells.reserve(NETP_EXECUTOR_CELL_CACHE);
+		}
+
+		~worker() {
+			for (std::size_t i = 0; i < cells.size(); ++i) {
+				netp::allocator<task>::trash(cells[i]);
+			}
+		}
+
+		//xorshift32, the victim to steal from first
+		inline u32_t next_rnd() {
+			rnd ^= rnd << 13;
+			rnd ^= rnd >> 17;
+			rnd ^= rnd << 5;
+			return rnd;
+		}
+	};
+
+	static __NETP_TLS executor::worker* __tls_executor_worker = nullptr;
+
+	executor::executor(u32_t count) :
+		m_state(S_IDLE),
+		m_count(count),
+		m_sleepers(0)
+	{
+		for (u8_t p = 0; p < EP_MAX; ++p) {
+			m_inj_size[p].store(0, std::memory_order_relaxed);
+		}
+		if (m_count == 0) {
+			m_count = std::thread::hardware_concurrency();
+			if (m_count == 0) {
+				m_count = 1;
+			}
+		}
+	}
+
+	executor::~executor() {
+		stop();
+	}
+
+	int executor::start() {
+		//the workers are ready before execute() sees S_RUNNING
+		worker_vector_t workers;
+		for (u32_t i = 0; i < m_count; ++i) {
+			worker* w = netp::allocator<worker>::make(this, i);
+			NETP_ALLOC_CHECK(w, sizeof(worker));
+			workers.push_back(w);
+		}
+		{
+			lock_guard<spin_mutex> lg(m_inj_mtx);
+			u8_t idle = S_IDLE;
+			if (!m_state.compare_exchange_strong(idle, u8_t(S_RUNNING), std::memory_order_acq_rel, std::memory_order_acquire)) {
+				for (u32_t i = 0; i < workers.size(); ++i) {
+					netp::allocator<worker>::trash(workers[i]);
+				}
+				return netp::E_INVALID_OPERATION;
+			}
+			m_workers.swap(workers);
+		}
+		for (u32_t i = 0; i < m_count; ++i) {
+			worker* w = m_workers[i];
+			w->th = netp::make_ref<netp::thread>();
+			int rt = w->th->start(&executor::_run, this, w);
+			if (rt != netp::OK) {
+				NETP_ERR("[executor]start worker %u failed: %d", i, rt);
+				w->th = nullptr;
+				stop();
+				return rt;
+			}
+		}
+		return netp::OK;
+	}
+
+	void executor::stop() {
+		//a worker would join its own thread
+		NETP_ASSERT(__tls_executor_worker == nullptr || __tls_executor_worker->E != this);
+		{
+			//a task injected before this point is run by the workers before they exit, the later ones are refused by execute()
+			lock_guard<spin_mutex> lg(m_inj_mtx);
+			u8_t running = S_RUNNING;
+			if (!m_state.compare_exchange_strong(running, u8_t(S_EXIT), std::memory_order_seq_cst, std::memory_order_acquire)) {
+				return;
+			}
+		}
+
+		for (u32_t i = 0; i < m_workers.size(); ++i) {
+			worker* w = m_workers[i];
+			netp::lock_guard<netp::mutex> lg(w->mtx);
+			w->notified = true;
+			w->cond.no_interrupt_notify_one();
+		}
+		for (u32_t i = 0; i < m_workers.size(); ++i) {
+			if (m_workers[i]->th != nullptr) {
+				m_workers[i]->th->join();
+				m_workers[i]->th = nullptr;
+			}
+		}
+		while (!m_workers.empty()) {
+			worker* w = m_workers.back();
+			m_workers.pop_back();
+			for (u8_t p = 0; p < EP_MAX; ++p) {
+				//left by a worker that failed to start
+				task* t;
+				while ((t = w->dq[p].pop()) != nullptr) {
+					netp::allocator<task>::trash(t);
+				}
+			}
+			netp::allocator<worker>::trash(w);
+		}
+		lock_guard<spin_mutex> lg(m_inj_mtx);
+		for (u8_t p = 0; p < EP_MAX; ++p) {
+			task t;
+			while (m_inj[p].pop(t)) {
+				m_inj_size[p].fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	executor_stat executor::stat() const {
+		executor_stat st = { 0, 0, 0 };
+		for (u32_t i = 0; i < m_workers.size(); ++i) {
+			st.executed += m_workers[i]->executed.load(std::memory_order_relaxed);
+			st.stolen += m_workers[i]->stolen.load(std::memory_order_relaxed);
+			st.parks += m_workers[i]->parks.load(std::memory_order_relaxed);
+		}
+		return st;
+	}
+
+	int executor::execute(task&& t, u8_t priority) {
+		NETP_ASSERT(priority < EP_MAX);
+		worker* w = __tls_executor_worker;
+		if (w != nullptr && w->E == this) {
+			task* tp = _cell_make(w);
+			*tp = std::move(t);
+			w->dq[priority].push(tp);
+			//pair with the seq_cst store of sleeping in _park
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			_unpark_one();
+			return netp::OK;
+		}
+
+		{
+			lock_guard<spin_mutex> lg(m_inj_mtx);
+			if (m_state.load(std::memory_order_relaxed) != S_RUNNING) {
+				t = nullptr;
+				return netp::E_INVALID_OPERATION;
+			}
+			m_inj[priority].push(std::move(t));
+			m_inj_size[priority].fetch_add(1, std::memory_order_seq_cst);
+		}
+		_unpark_one();
+		return netp::OK;
+	}
+
+	task* executor::_cell_make(worker* w) {
+		if (w->cells.empty()) {
+			task* t = netp::allocator<task>::make();
+			NETP_ALLOC_CHECK(t, sizeof(task));
+			return t;
+		}
+		task* t = w->cells.back();
+		w->cells.pop_back();
+		return t;
+	}
+
+	void executor::_cell_recycle(worker* w, task* t) {
+		//release the captures of the job right away
+		*t = nullptr;
+		if (w->cells.size() < NETP_EXECUTOR_CELL_CACHE) {
+			w->cells.push_back(t);
+		} else {
+			netp::allocator<task>::trash(t);
+		}
+	}
+
+	task* executor::_inj_pop(worker* w, u8_t priority) {
+		if (m_inj_size[priority].load(std::memory_order_seq_cst) == 0) {
+			return nullptr;
+		}
+		task* t = _cell_make(w);
+		{
+			lock_guard<spin_mutex> lg(m_inj_mtx);
+			if (m_inj[priority].pop(*t)) {
+				m_inj_size[priority].fetch_sub(1, std::memory_order_relaxed);
+				return t;
+			}
+		}
+		_cell_recycle(w, t);
+		return nullptr;
+	}
+
+	task* executor::_find(worker* w) {
+		for (u8_t p = 0; p < EP_MAX; ++p) {
+			task* t = w->dq[p].pop();
+			if (t != nullptr) {
+				return t;
+			}
+
+			t = _inj_pop(w, p);
+			if (t != nullptr) {
+				//more to take, wake up a sleeper to share them
+				if (m_inj_size[p].load(std::memory_order_seq_cst) > 0) {
+					_unpark_one();
+				}
+				return t;
+			}
+
+			const u32_t from = w->next_rnd();
+			for (u32_t i = 0; i < m_count; ++i) {
+				worker* v = m_workers[(from + i) % m_count];
+				if (v == w) {
+					continue;
+				}
+				t = v->dq[p].steal();
+				if (t != nullptr) {
+					w->stolen.fetch_add(1, std::memory_order_relaxed);
+					return t;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	bool executor::_has_work() const {
+		for (u8_t p = 0; p < EP_MAX; ++p) {
+			if (m_inj_size[p].load(std::memory_order_seq_cst) > 0) {
+				return true;
+			}
+			for (u32_t i = 0; i < m_count; ++i) {
+				if (!m_workers[i]->dq[p].empty()) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void executor::_park(worker* w) {
+		netp::unique_lock<netp::mutex> ulk(w->mtx);
+		w->sleeping.store(true, std::memory_order_seq_cst);
+		m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+		if (!_has_work() && m_state.load(std::memory_order_acquire) == S_RUNNING) {
+			w->parks.fetch_add(1, std::memory_order_relaxed);
+			while (!w->notified) {
+				w->cond.no_interrupt_wait(ulk);
+			}
+		}
+		w->notified = false;
+		m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+		w->sleeping.store(false, std::memory_order_relaxed);
+	}
+
+	void executor::_unpark(worker* w) {
+		netp::lock_guard<netp::mutex> lg(w->mtx);
+		if (w->sleeping.load(std::memory_order_relaxed)) {
+			w->notified = true;
+			w->cond.no_interrupt_notify_one();
+		}
+	}
+
+	void executor::_unpark_one() {
+		if (m_sleepers.load(std::memory_order_seq_cst) == 0) {
+			return;
+		}
+		for (u32_t i = 0; i < m_count; ++i) {
+			worker* w = m_workers[i];
+			if (w->sleeping.load(std::memory_order_acquire)) {
+				_unpark(w);
+				return;
+			}
+		}
+	}
+
+	void executor::_run(worker* w) {
+		__tls_executor_worker = w;
+		u32_t idle = 0;
+		while (1) {
+			//load the state before _find, a task injected before stop() is visible to _find once S_EXIT is seen
+			const bool running = m_state.load(std::memory_order_acquire) == S_RUNNING;
+			task* t = _find(w);
+			if (t != nullptr) {
+				idle = 0;
+				try {
+					(*t)();
+				} catch (netp::exception& e) {
+					NETP_ERR("[executor][-%u-]worker netp::exception: [%d]%s\n%s(%d) %s\n%s",
+						w->id, e.code(), e.what(), e.file(), e.line(), e.function(), e.callstack());
+				} catch (std::exception& e) {
+					NETP_ERR("[executor][-%u-]worker exception: %s", w->id, e.what());
+				} catch (...) {
+					NETP_ERR("[executor][-%u-]worker, unknown exception", w->id);
+				}
+				_cell_recycle(w, t);
+				w->executed.fetch_add(1, std::memory_order_relaxed);
+				continue;
+			}
+
+			if (!running) {
+				break;
+			}
+			if (++idle < NETP_EXECUTOR_SPIN_ROUND) {
+				netp::this_thread::no_interrupt_yield();
+				continue;
+			}
+			idle = 0;
+			_park(w);
+		}
+		__tls_executor_worker = nullptr;
+	}
+}
@@ -3,6 +3,10 @@
 #include <netp/socket_channel.hpp>
 #include <netp/app.hpp>
 
+#ifdef NETP_ENABLE_AF_UNIX
+	#include <sys/stat.h>
+#endif
+
 namespace netp {
 
 	int socket_channel::open() {
@@ -25,10 +29,38 @@ namespace netp {
 		return netp::OK;
 	}
 
+#ifdef NETP_ENABLE_AF_UNIX
+	//a socket file left by a process that did not close its listener, nobody accepts on it
+	//a live one is never taken: a connect to it either succeeds or fails with other than ECONNREFUSED
+	static bool __unix_path_is_stale(NRP<address> const& addr, int type) {
+		struct stat st;
+		if (::lstat(addr->unix_path().c_str(), &st) != 0 || !S_ISSOCK(st.st_mode)) {
+			return false;
+		}
+		const int fd = ::socket(AF_UNIX, type, 0);
+		if (fd == -1) {
+			return false;
+		}
+		const int rt = ::connect(fd, addr->sockaddr_raw(), addr->sockaddr_len());
+		const bool stale = (rt == -1) && (errno == ECONNREFUSED);
+		::close(fd);
+		return stale;
+	}
+#endif
+
 	int socket_channel::bind(NRP<address> const& addr) {
 		NETP_ASSERT(!m_laddr||m_laddr->is_af_unspec());
 		NETP_ASSERT((m_family) == addr->family());
 		int rt = socket_bind_impl(addr);
+#ifdef NETP_ENABLE_AF_UNIX
+		if ((rt == NETP_SOCKET_ERROR) && addr->is_unix() && !addr->is_unix_unnamed() && !addr->is_unix_abstract() &&
+			(netp_socket_get_last_errno() == netp::E_EADDRINUSE) && __unix_path_is_stale(addr, m_type))
+		{
+			NETP_WARN("[socket]unlink stale unix socket path: %s", addr->unix_path().c_str());
+			::unlink(addr->unix_path().c_str());
+			rt = socket_bind_impl(addr);
+		}
+#endif
 		NETP_RETURN_V_IF_MATCH(netp_socket_get_last_errno(), rt == NETP_SOCKET_ERROR);
 		m_laddr = addr->clone();
 		return netp::OK;
@@ -40,6 +72,21 @@ namespace netp {
 	int socket_channel::bind_any() {
 		NRP<address >_any_ = netp::make_ref<address>();
 		NETP_ASSERT(m_family != NETP_AF_UNSPEC);
+#ifdef NETP_ENABLE_AF_UNIX
+		if (m_family == NETP_AF_UNIX) {
+#ifdef NETP_ENABLE_AF_UNIX_ABSTRACT
+			//linux autobind, a bare sun_family gets a kernel picked abstract name, so that a unixgram peer is able to reply
+			_any_->setfamily(m_family);
+			_any_->sockaddr_loaded(sizeof(sa_family_t));
+			int rt = bind(_any_);
+			NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
+			return load_sockname();
+#else
+			//no autobind, the peer sees an unnamed sender
+			return netp::OK;
+#endif
+		}
+#endif
 		_any_->setfamily(m_family);
 		_any_->setipv4(dotiptoip("0.0.0.0"));
 		int rt;
@@ -244,6 +291,40 @@ int socket_base::get_left_snd_queue() const {
 		return netp::OK;
 	}
 
+	int socket_channel::get_tcp_info(socket_tcp_info& info) const {
+		//@note: m_fd is kept after netp::close, F_CLOSED keeps us off a fd number that might have been reused
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, (m_chflag&int(channel_flag::F_CLOSED)) || m_fd == NETP_INVALID_SOCKET || !is_tcp() || is_unix());
+		std::memset(&info, 0, sizeof(info));
+#ifdef NETP_ENABLE_SOCKET_TCP_INFO
+		tcp_info_raw raw;
+		std::memset(&raw, 0, sizeof(raw));
+		socklen_t len = sizeof(raw);
+		int rt = socket_getsockopt_impl(IPPROTO_TCP, TCP_INFO, (char*)&raw, &len);
+		NETP_RETURN_V_IF_MATCH(netp_socket_get_last_errno(), rt == NETP_SOCKET_ERROR);
+
+		info.state = raw.tcpi_state;
+		info.ca_state = raw.tcpi_ca_state;
+		info.retransmits = raw.tcpi_retransmits;
+		info.rtt_us = raw.tcpi_rtt;
+		info.rttvar_us = raw.tcpi_rttvar;
+		info.snd_mss = raw.tcpi_snd_mss;
+		info.snd_cwnd = raw.tcpi_snd_cwnd;
+		info.snd_ssthresh = raw.tcpi_snd_ssthresh;
+		info.unacked = raw.tcpi_unacked;
+		info.lost = raw.tcpi_lost;
+		info.total_retrans = raw.tcpi_total_retrans;
+		//raw is zeroed, the fields past a shorter copy of an older kernel stay 0
+		info.pacing_rate = raw.tcpi_pacing_rate;
+		info.bytes_acked = raw.tcpi_bytes_acked;
+		info.notsent_bytes = raw.tcpi_notsent_bytes;
+		info.min_rtt_us = raw.tcpi_min_rtt;
+		info.delivery_rate = raw.tcpi_delivery_rate;
+		return netp::OK;
+#else
+		return netp::E_EOPNOTSUPP;
+#endif
+	}
+
 	void socket_channel::_tmcb_tx_limit(NRP<timer> const& t) {
 		NETP_ASSERT(L->in_event_loop());
 		NETP_ASSERT( (m_tx_limit>0) && (m_chflag&int(channel_flag::F_TX_LIMIT_TIMER)) );
@@ -503,7 +584,7 @@ int socket_base::get_left_snd_queue() const {
 				}
 			}
 			
-			NRP<event_loop> LL = netp::app::instance()->def_loop_group()->next();
+			NRP<event_loop> LL = (listener_cfg->option & u16_t(socket_option::OPTION_ACCEPT_LOCAL)) ? L : netp::app::instance()->def_loop_group()->next();
 			LL->execute([LL,fn_initializer,nfd, laddr, raddr, listener_cfg]() {
 				NRP<socket_cfg> cfg_ = netp::make_ref<socket_cfg>();
 				cfg_->fd = nfd;
@@ -514,10 +595,18 @@ int socket_base::get_left_snd_queue() const {
 				cfg_->raddr = raddr;
 
 				cfg_->L = LL;
-				cfg_->option = listener_cfg->option;
+				cfg_->option = listener_cfg->option & ~(u16_t(socket_option::OPTION_ACCEPT_LOCAL)|u16_t(socket_option::OPTION_REUSEPORT));
 				cfg_->kvals = listener_cfg->kvals;
 				cfg_->sock_buf = listener_cfg->sock_buf;
 				cfg_->tx_limit = listener_cfg->tx_limit;
+				cfg_->zerocopy_threshold = listener_cfg->zerocopy_threshold;
+				cfg_->read_buf_min = listener_cfg->read_buf_min;
+				cfg_->read_buf_max = listener_cfg->read_buf_max;
+				cfg_->read_budget_bytes = listener_cfg->read_budget_bytes;
+				cfg_->read_budget_count = listener_cfg->read_budget_count;
+				cfg_->write_buf_high = listener_cfg->write_buf_high;
+				cfg_->write_buf_low = listener_cfg->write_buf_low;
+				cfg_->busy_poll_us = listener_cfg->busy_poll_us;
 				int rt;
 				NRP<socket_channel> so;
 				std::tie(rt, so) = create_socket_channel(cfg_);
@@ -552,18 +641,188 @@ int socket_base::get_left_snd_queue() const {
 		ch_close_impl(nullptr);
 	}
 
-	void socket_channel::__do_io_read_from(int status, io_ctx* ) {
+#ifdef NETP_ENABLE_SOCKET_RECVMMSG
+	void socket_channel::__do_io_read_from_batch(int status, io_ctx*) {
 		NETP_ASSERT(m_protocol == u8_t(NETP_PROTOCOL_UDP));
+		NETP_ASSERT(m_rcv_batch > 1 && m_rcv_batch <= NETP_SOCKET_RCV_BATCH_MAX);
+		struct mmsghdr _msgs[NETP_SOCKET_RCV_BATCH_MAX];
+		struct iovec _iov[NETP_SOCKET_RCV_BATCH_MAX];
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+		union {
+			byte_t buf[NETP_SOCKET_UDP_GRO_CMSG_SPACE];
+			struct cmsghdr align;
+		} _control[NETP_SOCKET_RCV_BATCH_MAX];
+		const bool gro = (m_option & u16_t(socket_option::OPTION_UDP_GRO)) != 0;
+#endif
+		const u32_t vlen = m_rcv_batch;
+		u32_t reads = 0;
+		u32_t total = 0;
 		while (status == netp::OK) {
 			NETP_ASSERT((m_chflag & (int(channel_flag::F_READ_SHUTDOWNING))) == 0);
 			if (NETP_UNLIKELY(m_chflag & (int(channel_flag::F_READ_SHUTDOWN) | int(channel_flag::F_CLOSE_PENDING)/*ignore the left read buffer, cuz we're closing it*/))) { return; }
+			if (__rcv_budget_exhausted(reads, total)) {
+				__rcv_budget_requeue();
+				return;
+			}
+
+			for (u32_t i = 0; i < vlen; ++i) {
+				NRP<netp::packet>& buf = L->channel_rcv_batch_buf(i);
+				NRP<netp::address>& addr = L->channel_rcv_batch_addr(i);
+				_iov[i].iov_base = buf->head();
+				_iov[i].iov_len = buf->left_right_capacity();
+				std::memset(&_msgs[i], 0, sizeof(struct mmsghdr));
+				_msgs[i].msg_hdr.msg_name = addr->sockaddr_raw();
+				_msgs[i].msg_hdr.msg_namelen = address::sockaddr_capacity();
+				_msgs[i].msg_hdr.msg_iov = &_iov[i];
+				_msgs[i].msg_hdr.msg_iovlen = 1;
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+				if (gro) {
+					_msgs[i].msg_hdr.msg_control = _control[i].buf;
+					_msgs[i].msg_hdr.msg_controllen = sizeof(_control[i].buf);
+				}
+#endif
+			}
+
+			const int n = socket_recvmmsg_impl(_msgs, vlen);
+			if (NETP_UNLIKELY(n < 0)) {
+				status = n;
+				break;
+			}
+			++reads;
+
+			for (int i = 0; i < n; ++i) {
+				if (NETP_UNLIKELY(m_chflag & (int(channel_flag::F_READ_SHUTDOWN) | int(channel_flag::F_CLOSE_PENDING)))) { return; }
+				NRP<netp::packet>& buf = L->channel_rcv_batch_buf(i);
+				NRP<netp::address>& from = L->channel_rcv_batch_addr(i);
+				from->sockaddr_loaded(_msgs[i].msg_hdr.msg_namelen);
+				total += _msgs[i].msg_len;
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+				const u16_t gro_size = gro ? netp::udp_gro_size(&_msgs[i].msg_hdr) : 0;
+				if (NETP_UNLIKELY(gro && (_msgs[i].msg_hdr.msg_flags & MSG_TRUNC))) {
+					__do_io_read_from_gro_truncated(_msgs[i].msg_len);
+					if (from.ref_count() != 1) {
+						from = nullptr;
+					}
+					continue;
+				} else if (gro_size != 0 && _msgs[i].msg_len > gro_size) {
+					__do_io_read_from_gro_fire(buf, _msgs[i].msg_len, gro_size, from);
+				} else {
+					buf->incre_write_idx(_msgs[i].msg_len);
+					channel::ch_fire_readfrom(buf, from);
+				}
+#else
+				buf->incre_write_idx(_msgs[i].msg_len);
+				channel::ch_fire_readfrom(buf, from);
+#endif
+
+				//reuse the slot if the handler did not keep a reference, or leave it to be refilled
+				if (buf.ref_count() == 1) {
+					buf->reset();
+				} else {
+					buf = nullptr;
+				}
+				if (from.ref_count() != 1) {
+					from = nullptr;
+				}
+			}
+		}
+		___do_io_read_done(status);
+	}
+#endif
+
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+	//@note: each segment is fired as a window of buf (read|write index adjusted), no copy as long as the handler does not hold the packet
+	//once it does, the left segments are copied out to keep the held one intact
+	void socket_channel::__do_io_read_from_gro_fire(NRP<packet> const& buf, u32_t nbytes, u16_t gro_size, NRP<address> const& from) {
+		NETP_ASSERT(gro_size > 0 && buf->len() == 0);
+		const u32_t base = buf->left_left_capacity();
+		byte_t* const data = buf->head();
+		for (u32_t off = 0; off < nbytes; off += gro_size) {
+			if (NETP_UNLIKELY(m_chflag & (int(channel_flag::F_READ_SHUTDOWN) | int(channel_flag::F_CLOSE_PENDING)))) { return; }
+			const u32_t seg = (nbytes - off) < gro_size ? (nbytes - off) : gro_size;
+			if (buf.ref_count() == 1) {
+				buf->reset(base + off);
+				buf->incre_write_idx(seg);
+				channel::ch_fire_readfrom(buf, from);
+			} else {
+				channel::ch_fire_readfrom(netp::make_ref<netp::packet>(data + off, seg), from);
+			}
+		}
+	}
+
+	void socket_channel::__do_io_read_from_gro_truncated(u32_t nbytes) {
+		if (m_rcv_truncated++ == 0) {
+			NETP_WARN("[socket][%s]udp gro read truncated at %u bytes, dropped, a read buffer of 64k holds any coalesced read", ch_info().c_str(), nbytes);
+		}
+	}
+#endif
+
+	void socket_channel::__rcv_budget_requeue() {
+		if (m_chflag & int(channel_flag::F_READ_REQUEUED)) {
+			return;
+		}
+		m_chflag |= int(channel_flag::F_READ_REQUEUED);
+		L->schedule([so = NRP<socket_channel>(this)]() {
+			so->m_chflag &= ~int(channel_flag::F_READ_REQUEUED);
+			//unwatched or closed in between
+			if ((so->m_chflag & (int(channel_flag::F_WATCH_READ) | int(channel_flag::F_READ_SHUTDOWN) | int(channel_flag::F_READ_ERROR) | int(channel_flag::F_CLOSE_PENDING) | int(channel_flag::F_CLOSING))) != int(channel_flag::F_WATCH_READ)) {
+				return;
+			}
+			so->io_notify_read(netp::OK, so->m_io_ctx);
+		});
+	}
+
+	void socket_channel::__do_io_read_from(int status, io_ctx* ctx) {
+		NETP_ASSERT(m_protocol == u8_t(NETP_PROTOCOL_UDP));
+#ifdef NETP_ENABLE_SOCKET_RECVMMSG
+		if (m_rcv_batch > 1) {
+			__do_io_read_from_batch(status, ctx);
+			return;
+		}
+#else
+		(void)ctx;
+#endif
+		u32_t reads = 0;
+		u32_t total = 0;
+		while (status == netp::OK) {
+			NETP_ASSERT((m_chflag & (int(channel_flag::F_READ_SHUTDOWNING))) == 0);
+			if (NETP_UNLIKELY(m_chflag & (int(channel_flag::F_READ_SHUTDOWN) | int(channel_flag::F_CLOSE_PENDING)/*ignore the left read buffer, cuz we're closing it*/))) { return; }
+			if (__rcv_budget_exhausted(reads, total)) {
+				__rcv_budget_requeue();
+				return;
+			}
 			NRP<netp::address> __address_nonnullptr_ = netp::make_ref<netp::address>();
 			NRP<netp::packet>& loop_buf = L->channel_rcv_buf();
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+			u16_t gro_size = 0;
+			bool trunc = false;
+			const int nbytes = (m_option & u16_t(socket_option::OPTION_UDP_GRO)) ?
+				socket_recvfrom_gro_impl(loop_buf->head(), loop_buf->left_right_capacity(), __address_nonnullptr_, gro_size, trunc) :
+				socket_recvfrom_impl(loop_buf->head(), loop_buf->left_right_capacity(), __address_nonnullptr_);
+#else
 			const int nbytes = socket_recvfrom_impl(loop_buf->head(), loop_buf->left_right_capacity(), __address_nonnullptr_);
+#endif
 			if (NETP_UNLIKELY(nbytes<0)) {
 				status = nbytes;
 				break;
 			}
+			++reads;
+			total += u32_t(nbytes);
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+			if (NETP_UNLIKELY(trunc)) {
+				__do_io_read_from_gro_truncated(u32_t(nbytes));
+				continue;
+			}
+			if (gro_size != 0 && u32_t(nbytes) > gro_size) {
+				__do_io_read_from_gro_fire(loop_buf, u32_t(nbytes), gro_size, __address_nonnullptr_);
+				if (loop_buf.ref_count() == 1) {
+					loop_buf->reset();
+				} else {
+					loop_buf = netp::make_ref<netp::packet>(L->channel_rcv_buf_size());
+				}
+				continue;
+			}
+#endif
 			loop_buf->incre_write_idx(nbytes);
 			NRP<netp::packet> __tmp =netp::make_ref<netp::packet>(L->channel_rcv_buf_size());
 			__tmp.swap(loop_buf);
@@ -582,15 +841,34 @@ int socket_base::get_left_snd_queue() const {
 
 		//in case socket object be destructed during ch_read
 
-		const int size = L->channel_rcv_buf_size();
+		//an adaptive read goes to a buffer of the guessed size class, the fired one is never larger than it has to be
+		NRP<netp::packet> adaptive_buf;
+		u32_t adaptive_total = 0;
+		int size = m_rcv_adaptive ? int(m_rcv_sizer.size()) : int(L->channel_rcv_buf_size());
 		int nbytes = size; //trick to skip the frist check
+		u32_t reads = 0;
+		u32_t total = 0;
+		bool requeue = false;
 		//refer to https://man7.org/linux/man-pages/man7/epoll.7.html tip 9
 		//if it is stream based, return value nbytes<size indicate that the buf has been exhausted
 		//socket_recv_impl set status to non-zero iff ::recv return -1
 		while ( (status == netp::OK) && ( (nbytes==size)|| !is_stream()) ) {
+			if (__rcv_budget_exhausted(reads, total)) {
+				requeue = true;
+				break;
+			}
 			NETP_ASSERT( (m_chflag&(int(channel_flag::F_READ_SHUTDOWNING))) == 0);
 			if (NETP_UNLIKELY(m_chflag & (int(channel_flag::F_READ_SHUTDOWN)|int(channel_flag::F_READ_ERROR) | int(channel_flag::F_CLOSE_PENDING) | int(channel_flag::F_CLOSING)/*ignore the left read buffer, cuz we're closing it*/))) { return; }
-			NRP<netp::packet>& loop_buf = L->channel_rcv_buf();
+			//the size class is updated once per wakeup, a buffer that got nothing is kept for the next read
+			if (m_rcv_adaptive && (adaptive_buf == nullptr)) {
+				NRP<netp::packet>& spare = L->channel_rcv_spare();
+				if ((spare != nullptr) && (spare->left_right_capacity() == u32_t(size))) {
+					adaptive_buf.swap(spare);
+				} else {
+					adaptive_buf = netp::make_ref<netp::packet>(size);
+				}
+			}
+			NRP<netp::packet>& loop_buf = m_rcv_adaptive ? adaptive_buf : L->channel_rcv_buf();
 			nbytes = socket_recv_impl(loop_buf->head(), size);
 			if (NETP_UNLIKELY(nbytes < 0)) {
 				status = nbytes;
@@ -607,11 +885,34 @@ int socket_base::get_left_snd_queue() const {
 
 			//@note: udp socket might receive a 0 len pkt
 			loop_buf->incre_write_idx(nbytes);
+			++reads;
+			total += u32_t(nbytes);
+			if (m_rcv_adaptive) {
+				adaptive_total += u32_t(nbytes);
+				NRP<netp::packet> __tmp;
+				__tmp.swap(adaptive_buf);
+				channel::ch_fire_read(std::move(__tmp));
+				continue;
+			}
 			NRP<netp::packet> __tmp = netp::make_ref<netp::packet>(size);
 			__tmp.swap(loop_buf);
 			channel::ch_fire_read(std::move(__tmp));
 		}
 
+		if (m_rcv_adaptive) {
+			if (adaptive_total != 0) {
+				m_rcv_sizer.record(adaptive_total);
+			}
+			if (adaptive_buf != nullptr) {
+				NETP_ASSERT(adaptive_buf->len() == 0);
+				L->channel_rcv_spare().swap(adaptive_buf);
+			}
+		}
+		if (requeue) {
+			__rcv_budget_requeue();
+			return;
+		}
+
 		//for epoll et, (nbytes<size && rdhub is set)
 #if defined(NETP_HAS_POLLER_EPOLL) && defined(NETP_DEFAULT_POLLER_TYPE_IS_EPOLL)
 		if ( (ioctx->flag&io_flag::IO_READ_HUP) && (status == netp::OK) ) {
@@ -646,6 +947,255 @@ int socket_base::get_left_snd_queue() const {
 		__do_io_write_done(status);
 	}
 
+	void socket_channel::__tx_limit_consume(u32_t nbytes) {
+		NETP_ASSERT(m_tx_limit != 0 && m_tx_budget >= nbytes);
+		m_tx_budget -= nbytes;
+		u32_t __tx_limit_clock_ms = netp::app::instance()->channel_tx_limit_clock();
+		if (!(m_chflag & int(channel_flag::F_TX_LIMIT_TIMER)) && ( (m_tx_budget < ((m_tx_limit/(1000/__tx_limit_clock_ms))) ) ) ) {
+			m_chflag |= int(channel_flag::F_TX_LIMIT_TIMER);
+			m_tx_limit_last_tp = netp::now<netp::microseconds_duration_t, netp::steady_clock_t>().time_since_epoch().count();
+			L->launch(netp::make_ref<netp::timer>(std::chrono::milliseconds(__tx_limit_clock_ms), &socket_channel::_tmcb_tx_limit, NRP<socket_channel>(this), std::placeholders::_1));
+		}
+	}
+
+#ifdef NETP_ENABLE_SOCKET_WRITEV
+	int socket_channel::___do_io_writev() {
+		struct iovec _iov[NETP_SOCKET_WRITEV_IOV_MAX];
+		while (m_tx_entry_q.size()) {
+#ifdef NETP_ENABLE_SOCKET_SENDFILE
+			if (m_tx_entry_q.front().file != nullptr) {
+				const int frt = socket_channel::___do_io_write_file();
+				if (frt != netp::OK) {
+					return frt;
+				}
+				continue;
+			}
+#endif
+#ifdef _NETP_DEBUG
+			NETP_ASSERT(m_tx_bytes > 0);
+#endif
+			const u32_t wlen_max = (m_tx_limit != 0) ? m_tx_budget : m_tx_bytes;
+			if (wlen_max == 0) {
+#ifdef _NETP_DEBUG
+				NETP_ASSERT(m_chflag&int(channel_flag::F_TX_LIMIT_TIMER));
+#endif
+				return netp::E_CHANNEL_TXLIMIT;
+			}
+
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+			if ((m_zc_threshold != 0) && (m_tx_entry_q.front().ref != nullptr) && (m_tx_entry_q.front().len() >= m_zc_threshold)) {
+				const int zrt = socket_channel::___do_io_write_zerocopy(wlen_max);
+				if (zrt == netp::OK) {
+					continue;
+				}
+				//ENOBUFS: out of optmem for the notification, copy this one
+				if (zrt != netp::E_ENOBUFS) {
+					return zrt;
+				}
+			}
+#endif
+
+			u32_t iovcnt = 0;
+			u32_t wlen = 0;
+			socket_outbound_entry_t::iterator it = m_tx_entry_q.begin();
+			while ( (it != m_tx_entry_q.end()) && (iovcnt < NETP_SOCKET_WRITEV_IOV_MAX) && (wlen < wlen_max) ) {
+				if (it->file != nullptr) {
+					break;
+				}
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+				if ((iovcnt > 0) && (m_zc_threshold != 0) && (it->ref != nullptr) && (it->len() >= m_zc_threshold)) {
+					break;
+				}
+#endif
+				u32_t dlen = it->len();
+				if (dlen > (wlen_max - wlen)) {
+					dlen = (wlen_max - wlen);
+				}
+				_iov[iovcnt].iov_base = it->head();
+				_iov[iovcnt].iov_len = dlen;
+				wlen += dlen;
+				++iovcnt;
+				++it;
+			}
+
+#ifdef _NETP_DEBUG
+			NETP_ASSERT((wlen > 0) && (wlen <= m_tx_bytes));
+#endif
+			//@note: single entry goes to socket_send_impl, it's cheaper than sendmsg
+			const int nbytes = (iovcnt == 1) ?
+				socket_send_impl((byte_t*)_iov[0].iov_base, u32_t(_iov[0].iov_len)) :
+				socket_sendmsg_impl(_iov, iovcnt);
+
+			if (NETP_UNLIKELY(nbytes < 0)) {
+				return nbytes;
+			}
+
+			m_tx_bytes -= nbytes;
+			if (m_tx_limit != 0) {
+				__tx_limit_consume(u32_t(nbytes));
+			}
+
+			//advance across entry boundaries, resolve in order
+			u32_t left = u32_t(nbytes);
+			while (left > 0) {
+				socket_outbound_entry& entry = m_tx_entry_q.front();
+				const u32_t dlen = entry.len();
+				if (left < dlen) {
+					entry.skip(left);
+					break;
+				}
+				left -= dlen;
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+				if (m_tx_zc_q.size()) {
+					m_tx_zc_q.push_back({ nullptr, std::move(entry.write_promise), 0, true });
+					m_tx_entry_q.pop_front();
+					continue;
+				}
+#endif
+				//write_promise->set might close the channel and clear the queue, pop before set
+				NRP<promise<int>> wp = std::move(entry.write_promise);
+				m_tx_entry_q.pop_front();
+				wp->set(netp::OK);
+			}
+		}
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+		//the completion comes with EPOLLERR, keep watching write for it if read is not watched
+		if (m_tx_zc_q.size() && !(m_chflag & int(channel_flag::F_WATCH_READ))) {
+			return netp::E_EWOULDBLOCK;
+		}
+#endif
+		return netp::OK;
+	}
+
+#ifdef NETP_ENABLE_SOCKET_SENDFILE
+	int socket_channel::___do_io_write_file() {
+		socket_outbound_entry& entry = m_tx_entry_q.front();
+		socket_outbound_file& f = *entry.file;
+		NETP_ASSERT(f.len > 0);
+		u32_t wlen = (f.len < u64_t(NETP_SOCKET_SENDFILE_MAX)) ? u32_t(f.len) : NETP_SOCKET_SENDFILE_MAX;
+		if (m_tx_limit != 0) {
+			if (m_tx_budget == 0) {
+#ifdef _NETP_DEBUG
+				NETP_ASSERT(m_chflag&int(channel_flag::F_TX_LIMIT_TIMER));
+#endif
+				return netp::E_CHANNEL_TXLIMIT;
+			}
+			if (wlen > m_tx_budget) {
+				wlen = m_tx_budget;
+			}
+		}
+
+		const int nbytes = socket_sendfile_impl(f.fd, f.offset, wlen);
+		if (NETP_UNLIKELY(nbytes < 0)) {
+			return nbytes;
+		}
+		if (NETP_UNLIKELY(nbytes == 0)) {
+			NETP_WARN("[socket][%s]sendfile reach eof, left: %llu", ch_info().c_str(), f.len);
+			return netp::E_CHANNEL_FILE_EOF;
+		}
+
+		if (m_tx_limit != 0) {
+			__tx_limit_consume(u32_t(nbytes));
+		}
+		m_tx_file_bytes -= u32_t(nbytes);
+		f.len -= u32_t(nbytes);
+		if (f.len != 0) {
+			return netp::OK;
+		}
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+		if (m_tx_zc_q.size()) {
+			m_tx_zc_q.push_back({ nullptr, std::move(entry.write_promise), 0, true });
+			m_tx_entry_q.pop_front();
+			return netp::OK;
+		}
+#endif
+		NRP<promise<int>> wp = std::move(entry.write_promise);
+		m_tx_entry_q.pop_front();
+		wp->set(netp::OK);
+		return netp::OK;
+	}
+#endif
+
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+	int socket_channel::___do_io_write_zerocopy(u32_t wlen_max) {
+		socket_outbound_entry& entry = m_tx_entry_q.front();
+		const u32_t dlen = entry.len();
+		const u32_t wlen = dlen < wlen_max ? dlen : wlen_max;
+		const int nbytes = socket_send_impl(entry.head(), wlen, MSG_ZEROCOPY);
+		if (NETP_UNLIKELY(nbytes < 0)) {
+			return nbytes;
+		}
+
+		m_tx_bytes -= nbytes;
+		if (m_tx_limit != 0) {
+			__tx_limit_consume(u32_t(nbytes));
+		}
+
+		//every successful send takes one id, the data must be kept until the completion of that id
+		//a partial send shares ref with the entry, the entry moves on by its offset
+		if (u32_t(nbytes) == dlen) {
+			m_tx_zc_q.push_back({ std::move(entry.ref), std::move(entry.write_promise), m_zc_id++, false });
+			m_tx_entry_q.pop_front();
+		} else {
+			m_tx_zc_q.push_back({ entry.ref, nullptr, m_zc_id++, false });
+			entry.skip(u32_t(nbytes));
+		}
+		return netp::OK;
+	}
+
+	void socket_channel::__tx_zerocopy_done(u32_t lo, u32_t hi) {
+		socket_zerocopy_entry_t::iterator it = m_tx_zc_q.begin();
+		while (it != m_tx_zc_q.end()) {
+			if ((it->data != nullptr) && (i32_t(it->id - lo) >= 0) && (i32_t(hi - it->id) >= 0)) {
+				it->done = true;
+			}
+			++it;
+		}
+
+		//completions might be out of order on retransmit, resolve the leading done ones only
+		while (m_tx_zc_q.size() && m_tx_zc_q.front().done) {
+			NRP<promise<int>> wp = std::move(m_tx_zc_q.front().write_promise);
+			m_tx_zc_q.pop_front();
+			if (wp != nullptr) {
+				wp->set(netp::OK);
+			}
+		}
+	}
+
+	void socket_channel::io_notify_errqueue(int status, io_ctx* ctx) {
+		NETP_ASSERT(L->in_event_loop());
+		(void)status;
+		u32_t lo, hi;
+		bool copied = false;
+		int rt;
+		while ((rt = socket_recverr_zerocopy_impl(lo, hi, copied)) >= 0) {
+			if (rt == 0) {
+				continue;
+			}
+			if (copied && (m_zc_threshold != 0)) {
+				//the kernel copied the pages anyway (loopback, nic without sg), it's cheaper to copy by send
+				NETP_VERBOSE("[socket][%s]zerocopy deferred copy, fallback to copy", ch_info().c_str());
+				m_zc_threshold = 0;
+			}
+			__tx_zerocopy_done(lo, hi);
+		}
+		if (rt != netp::E_EWOULDBLOCK) {
+			NETP_WARN("[socket][%s]read error queue failed: %d", ch_info().c_str(), rt);
+		}
+
+		if (m_chflag & int(channel_flag::F_WATCH_WRITE)) {
+			//flush the ones queued by write_promise callback, or end the watch for the last completion
+			if (m_chflag & int(channel_flag::F_USE_DEFAULT_WRITE)) {
+				io_notify_write(netp::OK, ctx);
+			}
+		} else if (m_tx_zc_q.empty() && (m_chflag & (int(channel_flag::F_CLOSE_PENDING) | int(channel_flag::F_WRITE_SHUTDOWN_PENDING))) &&
+			!(m_chflag & (int(channel_flag::F_WRITE_BARRIER) | int(channel_flag::F_TX_LIMIT)))) {
+			__do_io_write_done(netp::OK);
+		}
+	}
+#endif
+#endif
+
 	//write until error
 	//<0, is_error == (errno != E_CHANNEL_WRITING)
 	//==0, write done
@@ -653,19 +1203,25 @@ int socket_base::get_left_snd_queue() const {
 	int socket_channel::___do_io_write() {
 
 #ifdef _NETP_DEBUG
-		NETP_ASSERT( ch_is_connected() && m_tx_entry_q.size(), "%s, flag: %u", ch_info().c_str(), m_chflag);
+		NETP_ASSERT( ch_is_connected() && (m_tx_entry_q.size() || m_tx_zc_q.size()), "%s, flag: %u", ch_info().c_str(), m_chflag);
 #endif
 
 		NETP_ASSERT( m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)) );
 		NETP_ASSERT( (m_chflag&int(channel_flag::F_TX_LIMIT)) ==0);
 
+#ifdef NETP_ENABLE_SOCKET_WRITEV
+		if (is_stream()) {
+			return socket_channel::___do_io_writev();
+		}
+#endif
+
 		//there might be a chance to be blocked a while in this loop, if set trigger another write
 		while ( m_tx_entry_q.size() ) {
 #ifdef _NETP_DEBUG
 			NETP_ASSERT( is_udp() ? true: (m_tx_bytes) > 0 );
 #endif
 			socket_outbound_entry& entry = m_tx_entry_q.front();
-			const int dlen = int(entry.data->len());
+			const int dlen = int(entry.len());
 			int wlen = (dlen);
 			if (m_tx_limit !=0 && (m_tx_budget<u32_t(wlen))) {
 				if ( (m_tx_budget == 0) || is_udp()/*udp pkt could not be split into smaller pkt*/ ) {
@@ -681,7 +1237,7 @@ int socket_base::get_left_snd_queue() const {
 #ifdef _NETP_DEBUG
 			NETP_ASSERT((wlen > 0) && (u32_t(wlen) <= m_tx_bytes));
 #endif
-			const int nbytes = socket_send_impl( entry.data->head(), u32_t(wlen));
+			const int nbytes = socket_send_impl( entry.head(), u32_t(wlen));
 			if (NETP_UNLIKELY(nbytes < 0)) {
 				return nbytes;
 			}
@@ -693,13 +1249,7 @@ int socket_base::get_left_snd_queue() const {
 
 			m_tx_bytes -= nbytes;
 			if (m_tx_limit != 0 ) {
-				m_tx_budget -= nbytes;
-				u32_t __tx_limit_clock_ms = netp::app::instance()->channel_tx_limit_clock();
-				if (!(m_chflag & int(channel_flag::F_TX_LIMIT_TIMER)) && ( (m_tx_budget < ((m_tx_limit/(1000/__tx_limit_clock_ms))) ) ) ) {
-					m_chflag |= int(channel_flag::F_TX_LIMIT_TIMER);
-					m_tx_limit_last_tp = netp::now<netp::microseconds_duration_t, netp::steady_clock_t>().time_since_epoch().count();
-					L->launch(netp::make_ref<netp::timer>(std::chrono::milliseconds(__tx_limit_clock_ms), &socket_channel::_tmcb_tx_limit, NRP<socket_channel>(this), std::placeholders::_1));
-				}
+				__tx_limit_consume(u32_t(nbytes));
 			}
 
 			if ((nbytes == dlen)) {
@@ -707,9 +1257,9 @@ int socket_base::get_left_snd_queue() const {
 				m_tx_entry_q.pop_front();
 			} else {
 				NETP_ASSERT(!is_udp(), "proto: %u", sock_protocol() );
-				entry.data->skip(nbytes);
+				entry.skip(u32_t(nbytes));
 #ifdef _NETP_DEBUG
-				NETP_ASSERT(entry.data->len());
+				NETP_ASSERT(entry.len());
 #endif
 			}
 		}
@@ -725,26 +1275,106 @@ int socket_base::get_left_snd_queue() const {
 		//there might be a chance to be blocked a while in this loop, if set trigger another write
 		int status = netp::OK;
 		while ( m_tx_entry_to_q.size() ) {
+#ifdef NETP_ENABLE_SOCKET_SENDMMSG
+			//write_promise->set might queue more
+			if (m_tx_entry_to_q.size() > 1) {
+				return socket_channel::___do_io_write_to_batch();
+			}
+#endif
 			//@note: udp allow zero-len pkt
 			socket_outbound_entry_to& entry = m_tx_entry_to_q.front();
-			NETP_ASSERT((entry.data->len() <= m_tx_bytes));
-			status = socket_sendto_impl(entry.data->head(), (u32_t)entry.data->len(), entry.to);
+			NETP_ASSERT((entry.len() <= m_tx_bytes));
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+			status = (entry.gso_size == 0) ?
+				socket_sendto_impl(entry.head(), (u32_t)entry.len(), entry.to) :
+				socket_sendto_gso_impl(entry.head(), (u32_t)entry.len(), entry.to, entry.gso_size);
+#else
+			status = socket_sendto_impl(entry.head(), (u32_t)entry.len(), entry.to);
+#endif
 			if(status < 0) {
 				return status;
 			}
-			m_tx_bytes -= u32_t(entry.data->len());
-			entry.write_promise->set(netp::OK);
+			m_tx_bytes -= u32_t(entry.len());
+			NRP<promise<int>> wp = std::move(entry.write_promise);
 			m_tx_entry_to_q.pop_front();
+			wp->set(netp::OK);
 		}
 		return netp::OK;
 	}
 
+#ifdef NETP_ENABLE_SOCKET_SENDMMSG
+	int socket_channel::___do_io_write_to_batch() {
+		struct mmsghdr _msgs[NETP_SOCKET_SND_BATCH_MAX];
+		struct iovec _iov[NETP_SOCKET_SND_BATCH_MAX];
+		struct sockaddr_in _to[NETP_SOCKET_SND_BATCH_MAX];
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+		union {
+			byte_t buf[NETP_SOCKET_UDP_GSO_CMSG_SPACE];
+			struct cmsghdr align;
+		} _control[NETP_SOCKET_SND_BATCH_MAX];
+#endif
+
+		while (m_tx_entry_to_q.size()) {
+			u32_t vlen = 0;
+			socket_outbound_entry_to_t::iterator it = m_tx_entry_to_q.begin();
+			while ((it != m_tx_entry_to_q.end()) && (vlen < NETP_SOCKET_SND_BATCH_MAX)) {
+				NETP_ASSERT((it->len() <= m_tx_bytes));
+				_iov[vlen].iov_base = it->head();
+				_iov[vlen].iov_len = it->len();
+				std::memset(&_msgs[vlen], 0, sizeof(struct mmsghdr));
+				if (it->to != nullptr && it->to->is_unix()) {
+					_msgs[vlen].msg_hdr.msg_name = (void*)it->to->sockaddr_raw();
+					_msgs[vlen].msg_hdr.msg_namelen = it->to->sockaddr_len();
+				} else if (it->to != nullptr) {
+					std::memset(&_to[vlen], 0, sizeof(struct sockaddr_in));
+					_to[vlen].sin_family = u16_t(it->to->family());
+					_to[vlen].sin_port = it->to->nport();
+					_to[vlen].sin_addr.s_addr = it->to->nipv4().u32;
+					_msgs[vlen].msg_hdr.msg_name = &_to[vlen];
+					_msgs[vlen].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+				}
+				_msgs[vlen].msg_hdr.msg_iov = &_iov[vlen];
+				_msgs[vlen].msg_hdr.msg_iovlen = 1;
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+				if (it->gso_size != 0) {
+					netp::__udp_segment_cmsg(&_msgs[vlen].msg_hdr, _control[vlen].buf, it->gso_size);
+				}
+#endif
+				++vlen;
+				++it;
+			}
+
+			const int n = socket_sendmmsg_impl(_msgs, vlen);
+			if (NETP_UNLIKELY(n < 0)) {
+				return n;
+			}
+
+			//the sent ones are always at the front, the left stay in queue for the next round
+			//write_promise->set might close the channel and clear the queue, pop before set
+			for (int i = 0; (i < n) && !m_tx_entry_to_q.empty(); ++i) {
+				socket_outbound_entry_to& entry = m_tx_entry_to_q.front();
+				m_tx_bytes -= u32_t(entry.len());
+				NRP<promise<int>> wp = std::move(entry.write_promise);
+				m_tx_entry_to_q.pop_front();
+				wp->set(netp::OK);
+			}
+		}
+		return netp::OK;
+	}
+#endif
+
 	void socket_channel::_ch_do_close_listener() {
 		NETP_ASSERT(L->in_event_loop());
 		NETP_ASSERT(m_chflag & int(channel_flag::F_LISTENING));
 		NETP_ASSERT((m_chflag & int(channel_flag::F_CLOSED)) ==0 );
 
 		m_chflag |= int(channel_flag::F_CLOSED);
+#ifdef NETP_ENABLE_AF_UNIX
+		//the path of a unix listener outlives the socket, a later bind on it would get EADDRINUSE
+		if (m_laddr != nullptr && m_laddr->is_unix() && !m_laddr->is_unix_unnamed() && !m_laddr->is_unix_abstract()) {
+			::unlink(m_laddr->unix_path().c_str());
+		}
+#endif
 		ch_io_end_accept();
 		ch_io_end();
 		NETP_TRACE_SOCKET("[socket][%s]ch_do_close_listener end", ch_info().c_str());
@@ -765,8 +1395,8 @@ int socket_base::get_left_snd_queue() const {
 		_ch_do_close_read();
 		_ch_do_close_write();
 
-		NETP_ASSERT(m_tx_entry_q.empty() && m_tx_entry_to_q.empty() );
-		NETP_ASSERT(m_tx_bytes == 0);
+		NETP_ASSERT(m_tx_entry_q.empty() && m_tx_zc_q.empty() && m_tx_entry_to_q.empty() );
+		NETP_ASSERT(m_tx_bytes == 0 && m_tx_file_bytes == 0);
 
 		//close read, close write might result in F_CLOSED
 		m_chflag &= ~(int(channel_flag::F_CLOSING));
@@ -793,6 +1423,7 @@ int socket_base::get_left_snd_queue() const {
 	void socket_channel::ch_close_write_impl(NRP<promise<int>> const& closep) {
 		NETP_ASSERT(L->in_event_loop());
 		NETP_ASSERT(!ch_is_listener());
+		__ch_flush_held();
 		int prt = netp::OK;
 		if (m_chflag & int(channel_flag::F_WRITE_SHUTDOWN)) {
 			prt = (netp::E_CHANNEL_WRITE_CLOSED);
@@ -801,19 +1432,19 @@ int socket_base::get_left_snd_queue() const {
 		} else if (m_chflag&(int(channel_flag::F_CLOSE_PENDING)|int(channel_flag::F_WRITE_SHUTDOWN_PENDING))) {
 			//if we have a write_error, a immediate ch_close_impl would be take out
 			NETP_ASSERT((m_chflag&int(channel_flag::F_WRITE_ERROR)) == 0);
-			NETP_ASSERT(m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT)) );
-			NETP_ASSERT((m_fn_write == nullptr) ? (m_tx_entry_q.size()||m_tx_entry_to_q.size()): true, "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
+			NETP_ASSERT((m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT))) || m_tx_zc_q.size() );
+			NETP_ASSERT((m_fn_write == nullptr) ? (m_tx_entry_q.size()||m_tx_zc_q.size()||m_tx_entry_to_q.size()||(m_chflag&int(channel_flag::F_WRITE_BARRIER))): true, "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
 			prt = (netp::E_CHANNEL_WRITE_SHUTDOWNING);
-		} else if (m_chflag & (int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT)) ) {
+		} else if ((m_chflag & (int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT))) || m_tx_zc_q.size() ) {
 			//write set ok might result in ch_close_write|ch_close
 			//the pending action would be scheduled right in _do_write_done() which is right after every _io_do_write action
 			//if a user defined write function is used, user have to take care of it by user self
-			NETP_ASSERT((m_fn_write==nullptr) ? (m_tx_entry_q.size()||m_tx_entry_to_q.size()): true, "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno );
+			NETP_ASSERT((m_fn_write==nullptr) ? (m_tx_entry_q.size()||m_tx_zc_q.size()||m_tx_entry_to_q.size()||(m_chflag&int(channel_flag::F_WRITE_BARRIER))): true, "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno );
 			m_chflag |= int(channel_flag::F_WRITE_SHUTDOWN_PENDING);
 			prt = (netp::E_CHANNEL_WRITE_SHUTDOWNING);
 		} else {
 			NETP_ASSERT(((m_chflag&(int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_CONNECTED) )) == (int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_CONNECTED) | int(channel_flag::F_USE_DEFAULT_WRITE))) ?
-				(m_tx_entry_q.size()||m_tx_entry_to_q.size()):
+				(m_tx_entry_q.size()||m_tx_zc_q.size()||m_tx_entry_to_q.size()):
 				true, "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
 
 			_ch_do_close_write();
@@ -825,6 +1456,7 @@ int socket_base::get_left_snd_queue() const {
 	//ERROR FIRST
 	void socket_channel::ch_close_impl(NRP<promise<int>> const& closep) {
 		NETP_ASSERT(L->in_event_loop());
+		__ch_flush_held();
 
 		int prt = netp::OK;
 		if (m_chflag&int(channel_flag::F_CLOSED)) {
@@ -836,19 +1468,19 @@ int socket_base::get_left_snd_queue() const {
 		} else if (m_chflag & (int(channel_flag::F_READ_ERROR) | int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_FIRE_ACT_EXCEPTION))) {
 			NETP_ASSERT( ch_errno() != netp::OK );
 			NETP_ASSERT(((m_chflag & (int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_CONNECTED) | int(channel_flag::F_USE_DEFAULT_WRITE))) == (int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_CONNECTED) | int(channel_flag::F_USE_DEFAULT_WRITE))) ?
-				(m_tx_entry_q.size()||m_tx_entry_to_q.size()):
+				(m_tx_entry_q.size()||m_tx_zc_q.size()||m_tx_entry_to_q.size()):
 				true, "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
 
 			goto __act_label_close_read_write;
 		} else if ( m_chflag & (int(channel_flag::F_CLOSE_PENDING)| int(channel_flag::F_WRITE_SHUTDOWN_PENDING)) ) {
-			NETP_ASSERT(m_chflag & (int(channel_flag::F_WRITE_BARRIER) | int(channel_flag::F_WATCH_WRITE) | int(channel_flag::F_TX_LIMIT)));
-			NETP_ASSERT(m_chflag&(int(channel_flag::F_USE_DEFAULT_WRITE)) ? (m_tx_entry_q.size()||m_tx_entry_to_q.size()) : true, "[#%s]chflag: %d, cherrno: %d", ch_info().c_str(), m_chflag, m_cherrno);
+			NETP_ASSERT((m_chflag & (int(channel_flag::F_WRITE_BARRIER) | int(channel_flag::F_WATCH_WRITE) | int(channel_flag::F_TX_LIMIT))) || m_tx_zc_q.size());
+			NETP_ASSERT(m_chflag&(int(channel_flag::F_USE_DEFAULT_WRITE)) ? (m_tx_entry_q.size()||m_tx_zc_q.size()||m_tx_entry_to_q.size()||(m_chflag&int(channel_flag::F_WRITE_BARRIER))) : true, "[#%s]chflag: %d, cherrno: %d", ch_info().c_str(), m_chflag, m_cherrno);
 			prt = (netp::E_OP_INPROCESS);
-		} else if (m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT)) ) {
+		} else if ((m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT))) || m_tx_zc_q.size() ) {
 			//wait for write done event, we might in a write barrier
 			//for a non-error close, do grace shutdown
 			//for error close, we would not reach here
-			NETP_ASSERT((m_fn_write == nullptr) ? (m_tx_entry_q.size()||m_tx_entry_to_q.size()) : true, "[#%s]chflag: %d, cherrno: %d", ch_info().c_str(),  m_chflag, m_cherrno);
+			NETP_ASSERT((m_fn_write == nullptr) ? (m_tx_entry_q.size()||m_tx_zc_q.size()||m_tx_entry_to_q.size()||(m_chflag&int(channel_flag::F_WRITE_BARRIER))) : true, "[#%s]chflag: %d, cherrno: %d", ch_info().c_str(),  m_chflag, m_cherrno);
 			m_chflag |= int(channel_flag::F_CLOSE_PENDING);
 			prt = (netp::E_CHANNEL_CLOSING);
 		} else {
@@ -867,7 +1499,7 @@ __act_label_close_read_write:
 		const u32_t outlet_len = (u32_t)outlet->len(); \
 		/*set the threshold arbitrarily high, the writer have to check the return value if */ \
 		if ( (m_tx_bytes > 0) && ( (m_tx_bytes + outlet_len) > /*m_sock_buf.sndbuf_size,*/u32_t(channel_buf_range::CH_BUF_SND_MAX_SIZE))) { \
-			NETP_ASSERT(m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE))); \
+			NETP_ASSERT(m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_WRITE_HOLD))); \
 			chp->set(netp::E_CHANNEL_WRITE_BLOCK); \
 			return; \
 		} \
@@ -886,13 +1518,16 @@ __act_label_close_read_write:
 			NETP_ASSERT((m_chflag & (int(channel_flag::F_WATCH_WRITE) | int(channel_flag::F_TX_LIMIT))) ? m_tx_entry_q.size() : true, "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
 #endif
 
-		m_tx_entry_q.push_back({
-			netp::make_ref<netp::non_atomic_ref_packet>(outlet->head(), outlet_len,0),
-			intp
-		});
+		//a zerocopy one is referenced as well, a copy here would cost what MSG_ZEROCOPY saves
+		if ((m_option&u16_t(socket_option::OPTION_WRITE_NOCOPY)) || ((m_zc_threshold != 0) && (outlet_len >= m_zc_threshold))) {
+			m_tx_entry_q.push_back({ nullptr, outlet, 0, intp, nullptr });
+		} else {
+			m_tx_entry_q.push_back({ netp::make_ref<netp::non_atomic_ref_packet>(outlet->head(), outlet_len,0), nullptr, 0, intp, nullptr });
+		}
 		m_tx_bytes += outlet_len;
+		__tx_watermark_check();
 
-		if (m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT))) {
+		if (m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT)|int(channel_flag::F_WRITE_HOLD))) {
 			return;
 		}
 
@@ -906,8 +1541,91 @@ __act_label_close_read_write:
 #endif
 	}
 
+	void socket_channel::__tx_writability_changed() {
+		if (m_tx_writability_pending) {
+			return;
+		}
+		m_tx_writability_pending = true;
+		L->schedule([so = NRP<socket_channel>(this)]() {
+			so->m_tx_writability_pending = false;
+			const bool writable = so->ch_is_writable();
+			//flipped back before we get here
+			if ((writable == so->m_tx_writable_fired) || (so->m_chflag & (int(channel_flag::F_CLOSING) | int(channel_flag::F_CLOSED)))) {
+				return;
+			}
+			so->m_tx_writable_fired = writable;
+			so->ch_fire_writability_changed();
+		});
+	}
+
+	void socket_channel::ch_flush_impl() {
+		NETP_ASSERT(L->in_event_loop());
+		if ((m_tx_entry_q.size() == 0) && (m_tx_entry_to_q.size() == 0)) {
+			return;
+		}
+		//in flight already, or nothing could be written
+		if (m_chflag & (int(channel_flag::F_WRITE_BARRIER) | int(channel_flag::F_WATCH_WRITE) | int(channel_flag::F_TX_LIMIT) |
+			int(channel_flag::F_READ_ERROR) | int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_FIRE_ACT_EXCEPTION) |
+			int(channel_flag::F_WRITE_SHUTDOWNING) | int(channel_flag::F_WRITE_SHUTDOWN) | int(channel_flag::F_CLOSING) | int(channel_flag::F_CLOSED))) {
+			return;
+		}
+
+#ifdef NETP_ENABLE_FAST_WRITE
+		m_chflag |= int(channel_flag::F_WRITE_BARRIER);
+		ch_is_connected() ? __do_io_write(netp::OK, m_io_ctx) : __do_io_write_to(netp::OK, m_io_ctx);
+		m_chflag &= ~int(channel_flag::F_WRITE_BARRIER);
+#else
+		ch_io_write();
+#endif
+	}
+
+	void socket_channel::ch_write_file_impl(NRP<promise<int>> const& intp, int fd, u64_t offset, u64_t len) {
+#ifdef _NETP_DEBUG
+		NETP_ASSERT(L->in_event_loop());
+		NETP_ASSERT(intp != nullptr);
+#endif
+#ifdef NETP_ENABLE_SOCKET_SENDFILE
+		if (!is_stream()) {
+			intp->set(netp::E_EOPNOTSUPP);
+			return;
+		}
+		if (m_chflag&(int(channel_flag::F_READ_ERROR)|int(channel_flag::F_WRITE_ERROR)|int(channel_flag::F_WRITE_SHUTDOWN)|int(channel_flag::F_WRITE_SHUTDOWN_PENDING)|int(channel_flag::F_WRITE_SHUTDOWNING)|int(channel_flag::F_CLOSE_PENDING)|int(channel_flag::F_CLOSING) ) ) {
+			intp->set(netp::E_CHANNEL_WRITE_ABORT);
+			return;
+		}
+		if (len == 0) {
+			intp->set(netp::OK);
+			return;
+		}
+
+		m_tx_entry_q.push_back({ nullptr, nullptr, 0, intp, netp::make_ref<socket_outbound_file>(fd, offset, len) });
+		m_tx_file_bytes += len;
+		__tx_watermark_check();
+		if (m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_TX_LIMIT)|int(channel_flag::F_WRITE_HOLD))) {
+			return;
+		}
+
+#ifdef NETP_ENABLE_FAST_WRITE
+		m_chflag |= int(channel_flag::F_WRITE_BARRIER);
+		__do_io_write(netp::OK, m_io_ctx);
+		m_chflag &= ~int(channel_flag::F_WRITE_BARRIER);
+#else
+		ch_io_write();
+#endif
+#else
+		(void)fd;
+		(void)offset;
+		(void)len;
+		intp->set(netp::E_EOPNOTSUPP);
+#endif
+	}
+
 	//@note: udp could send zero-len pkt
 	void socket_channel::ch_write_to_impl( NRP<promise<int>> const& intp, NRP<packet> const& outlet,NRP<netp::address >const& to) {
+		socket_channel::__ch_write_to_impl(intp, outlet, to, m_gso_size);
+	}
+
+	void socket_channel::__ch_write_to_impl(NRP<promise<int>> const& intp, NRP<packet> const& outlet, NRP<netp::address> const& to, u16_t gso_size) {
 #ifdef _NETP_DEBUG
 		NETP_ASSERT(L->in_event_loop());
 		NETP_ASSERT(intp != nullptr);
@@ -919,14 +1637,30 @@ __act_label_close_read_write:
 			NETP_ASSERT(!ch_is_connected(), "socket[%s]flag: %u", ch_info().c_str(), m_chflag);
 #endif
 
-		m_tx_entry_to_q.push_back({
-			netp::make_ref<netp::non_atomic_ref_packet>(outlet->head(), outlet_len,0),
-			intp,
-			to
-		});
+		if (outlet_len <= gso_size) {
+			gso_size = 0;
+		}
+		if (gso_size != 0) {
+#ifdef NETP_ENABLE_SOCKET_UDP_GSO
+			if (((outlet_len + gso_size - 1) / gso_size) > NETP_SOCKET_UDP_GSO_MAX_SEGMENTS) {
+				intp->set(netp::E_EMSGSIZE);
+				return;
+			}
+#else
+			intp->set(netp::E_EOPNOTSUPP);
+			return;
+#endif
+		}
+
+		if (m_option&u16_t(socket_option::OPTION_WRITE_NOCOPY)) {
+			m_tx_entry_to_q.push_back({ nullptr, outlet, intp, to, gso_size });
+		} else {
+			m_tx_entry_to_q.push_back({ netp::make_ref<netp::non_atomic_ref_packet>(outlet->head(), outlet_len,0), nullptr, intp, to, gso_size });
+		}
 		m_tx_bytes += outlet_len;
+		__tx_watermark_check();
 
-		if (m_chflag & (int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)) ) {
+		if (m_chflag & (int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_WRITE_HOLD)) ) {
 			return;
 		}
 
@@ -961,7 +1695,18 @@ __act_label_close_read_write:
 	void socket_channel::io_notify_read(int status, io_ctx* ctx) {
 		NETP_ASSERT(m_chflag & int(channel_flag::F_WATCH_READ), "[socket][%s]", ch_info().c_str() );
 		if (m_chflag & int(channel_flag::F_USE_DEFAULT_READ)) {
+			if ((m_option & (u16_t(socket_option::OPTION_WRITE_BATCH)|u16_t(socket_option::OPTION_WRITE_HOLD))) == 0) {
+				ch_is_connected() ? __do_io_read(status, ctx) : __do_io_read_from(status, ctx);
+				return;
+			}
+			//writes made by the read handlers go out together at the end of the batch
+			const bool set_here = (m_chflag & int(channel_flag::F_WRITE_HOLD)) == 0;
+			m_chflag |= int(channel_flag::F_WRITE_HOLD);
 			ch_is_connected() ? __do_io_read(status, ctx) : __do_io_read_from(status, ctx);
+			if (set_here) {
+				m_chflag &= ~int(channel_flag::F_WRITE_HOLD);
+			}
+			ch_flush_impl();
 			return;
 		}
 		NETP_ASSERT( m_fn_read != nullptr );
@@ -1014,8 +1759,8 @@ __act_label_close_read_write:
 
 		void socket_channel::ch_io_end() {
 			NETP_ASSERT(L->in_event_loop());
-			NETP_ASSERT(m_tx_bytes == 0);
-			NETP_ASSERT(m_tx_entry_q.empty() && m_tx_entry_to_q.empty(), "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
+			NETP_ASSERT(m_tx_bytes == 0 && m_tx_file_bytes == 0);
+			NETP_ASSERT(m_tx_entry_q.empty() && m_tx_zc_q.empty() && m_tx_entry_to_q.empty(), "[#%s]flag: %d, errno: %d", ch_info().c_str(), m_chflag, m_cherrno);
 			NETP_ASSERT(m_chflag & int(channel_flag::F_CLOSED));
 			NETP_ASSERT((m_chflag & (int(channel_flag::F_WATCH_READ) | int(channel_flag::F_WATCH_WRITE) | int(channel_flag::F_CONNECTED) )) == 0);
 			NETP_TRACE_SOCKET("[socket][%s]io_action::END, flag: %d", ch_info().c_str(), m_chflag);
@@ -1099,7 +1844,15 @@ __act_label_close_read_write:
 					NETP_WARN("[socket][%s]io_action::END_READ, rt: %d, close socket_channel", ch_info().c_str(), rt );
 					ch_errno() = rt;
 					ch_close_impl(nullptr);
+					return;
+				}
+
+#ifdef NETP_ENABLE_SOCKET_ZEROCOPY
+				//the fd must stay in poller for the pending zerocopy completion
+				if (m_tx_zc_q.size() && !(m_chflag & (int(channel_flag::F_WATCH_WRITE) | int(channel_flag::F_TX_LIMIT) | int(channel_flag::F_CLOSING) | int(channel_flag::F_READ_ERROR) | int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_WRITE_SHUTDOWNING) | int(channel_flag::F_WRITE_SHUTDOWN)))) {
+					ch_io_write();
 				}
+#endif
 			}
 		}
 
@@ -1175,7 +1928,7 @@ __act_label_close_read_write:
 		//please do ch_io_begin by manual
 
 		NRP<netp::promise<std::tuple<int, NRP<socket_channel>>>> socket_channel::dup(NRP<event_loop> const& LL) {
-			NETP_ASSERT( (L->poller_type() == LL->poller_type()) && (LL->poller_type() == NETP_DEFAULT_POLLER_TYPE) );
+			NETP_ASSERT( (L->poller_type() == LL->poller_type()) && NETP_IS_SOCKET_POLLER_TYPE(LL->poller_type()) );
 
 			NRP<netp::promise<std::tuple<int, NRP<socket_channel>>>> p =
 				netp::make_ref<netp::promise<std::tuple<int, NRP<socket_channel>>>>();
@@ -9,7 +9,7 @@ namespace netp {
 	void socket_channel_iocp::__ch_io_cancel_connect(int status, io_ctx* ctx_) {
 		iocp_ctx* ctx = (iocp_ctx*)ctx_;
 		NETP_ASSERT(L->in_event_loop());
-		NETP_ASSERT(status == netp::E_IO_EVENT_LOOP_NOTIFY_TERMINATING);
+		NETP_ASSERT(status != netp::OK);
 
 		NETP_ASSERT(m_chflag & int(channel_flag::F_CONNECTING) ); 
 		NETP_ASSERT(ctx->ol_w->fn_ol_done != nullptr );
@@ -239,13 +239,15 @@ namespace netp {
 		}
 		iocp_ctx* ctx = (iocp_ctx*)ctx_;
 		NETP_ASSERT(m_tx_bytes > 0);
-		socket_outbound_entry entry = m_tx_entry_q.front();
-		NETP_ASSERT(entry.data != nullptr);
+		socket_outbound_entry& entry = m_tx_entry_q.front();
+		NETP_ASSERT(entry.data != nullptr || entry.ref != nullptr);
 		m_tx_bytes -= status;
-		entry.data->skip(status);
-		if (entry.data->len() == 0) {
-			entry.write_promise->set(netp::OK);
+		if (u32_t(status) == entry.len()) {
+			NRP<promise<int>> wp = std::move(entry.write_promise);
 			m_tx_entry_q.pop_front();
+			wp->set(netp::OK);
+		} else {
+			entry.skip(u32_t(status));
 		}
 		status = netp::OK;
 		if (m_tx_bytes > 0) {
@@ -266,7 +268,7 @@ namespace netp {
 
 		NETP_ASSERT(m_tx_bytes > 0);
 		socket_outbound_entry& entry = m_tx_entry_q.front();
-		olctx->wsabuf = { ULONG(entry.data->len()), (char*)entry.data->head() };
+		olctx->wsabuf = { ULONG(entry.len()), (char*)entry.head() };
 		ol_ctx_reset(olctx);
 		int rt = ::WSASend(m_fd, &olctx->wsabuf, 1, NULL, 0, &olctx->ol, NULL);
 		if (rt == NETP_SOCKET_ERROR) {
@@ -3,7 +3,21 @@
 
 namespace netp {
 
+	static inline bool __is_unix_proto(string_t const& proto) {
+		return netp::iequals<string_t>(proto, string_t("unix")) || netp::iequals<string_t>(proto, string_t("unixgram"));
+	}
+
 	int parse_socket_url(const char* url, size_t len, socket_url_parse_info& info) {
+		//unix://path, unixgram://path, unix://@name for the abstract namespace, the path might contain ':'
+		const string_t _url(url, len);
+		const string_t::size_type _pos = _url.find("://");
+		if (_pos != string_t::npos && __is_unix_proto(_url.substr(0, _pos))) {
+			info.proto = _url.substr(0, _pos);
+			info.host = _url.substr(_pos + 3);
+			info.port = 0;
+			return info.host.length() ? netp::OK : netp::E_SOCKET_INVALID_ADDRESS;
+		}
+
 		std::vector<string_t> _arr;
 		netp::split<string_t>(string_t(url, len), ":", _arr);
 		if (_arr.size() != 3) {
@@ -22,6 +36,16 @@ namespace netp {
 	}
 
 	std::tuple<int, u8_t, u8_t, u16_t> inspect_address_info_from_dial_str(const char* dialstr) {
+		//the protocol of a unix socket picks the stream|datagram path of the channel
+		if (__is_unix_proto(string_t(dialstr))) {
+#ifdef NETP_ENABLE_AF_UNIX
+			const bool gram = netp::iequals<string_t>(string_t(dialstr), string_t("unixgram"));
+			return std::make_tuple(netp::OK, u8_t(NETP_AF_UNIX), u8_t(gram ? NETP_SOCK_DGRAM : NETP_SOCK_STREAM), u16_t(gram ? NETP_PROTOCOL_UDP : NETP_PROTOCOL_TCP));
+#else
+			return std::make_tuple(netp::E_EOPNOTSUPP, u8_t(NETP_AF_UNSPEC), u8_t(0), u16_t(NETP_PROTOCOL_UNKNOWN));
+#endif
+		}
+
 		u16_t sproto = DEF_protocol_str_to_proto(dialstr);
 		u8_t family;
 		u8_t stype;
@@ -53,6 +77,20 @@ namespace netp {
 		return std::make_tuple(netp::OK, family, stype, sproto);
 	}
 
+	static int __make_unix_address(string_t const& path, NRP<address>& addr) {
+#ifdef NETP_ENABLE_AF_UNIX
+		if (path.length() == 0 || path.length() >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+			return netp::E_SOCKET_INVALID_ADDRESS;
+		}
+		addr = netp::make_ref<address>(path.c_str(), path.length());
+		return netp::OK;
+#else
+		(void)path;
+		(void)addr;
+		return netp::E_EOPNOTSUPP;
+#endif
+	}
+
 	NRP<socket_channel> default_socket_channel_maker(NRP<netp::socket_cfg> const& cfg) {
 #ifdef NETP_HAS_POLLER_IOCP
 		return netp::make_ref<socket_channel_iocp>(cfg);
@@ -65,13 +103,13 @@ namespace netp {
 
 		NRP<socket_channel> __socketch;
 		if (cfg->family == NETP_AF_USER) {
-			NETP_ASSERT(cfg->L->poller_type() != NETP_DEFAULT_POLLER_TYPE);
+			NETP_ASSERT(!NETP_IS_SOCKET_POLLER_TYPE(cfg->L->poller_type()));
 			if (cfg->ch_maker == nullptr) {
 				return std::make_tuple(netp::E_CHANNEL_MISSING_MAKER, nullptr);
 			}
 			__socketch = cfg->ch_maker(cfg);
 		} else {
-			NETP_ASSERT(cfg->L->poller_type() == NETP_DEFAULT_POLLER_TYPE);
+			NETP_ASSERT(NETP_IS_SOCKET_POLLER_TYPE(cfg->L->poller_type()));
 			NETP_ASSERT(cfg->ch_maker == nullptr);
 			__socketch = default_socket_channel_maker(cfg);
 		}
@@ -146,9 +184,148 @@ namespace netp {
 		__socketch->do_dial(so_dialp, addr, initializer);
 	}
 
+	//@note: all the attempts of a race live on cfg->L
+	//the first attempt that reaches the initializer wins and cancels the connecting others, a late one is refused before the initializer of the user runs
+	struct dial_race final :
+		public netp::ref_base
+	{
+		NRP<channel_dial_promise> ch_dialf;
+		std::vector<NRP<address>, netp::allocator<NRP<address>>> addrs;
+		fn_channel_initializer_t initializer;
+		NRP<socket_cfg> cfg;
+
+		netp::size_t next;
+		netp::size_t inflight;
+		int last_rt;
+		socket_channel* winner;
+		i64_t begin_us;
+		std::vector<NRP<socket_channel>> connecting;
+	};
+
+	static inline i64_t __dial_race_now_us() {
+		return netp::now<microseconds_duration_t, steady_clock_t>().time_since_epoch().count();
+	}
+
+	static void __dial_race_attempt(NRP<dial_race> const& r);
+
+	static void __dial_race_attempt_done(NRP<dial_race> const& r, NRP<socket_channel> const& so, NRP<address> const& addr, i64_t start_us, int rt) {
+		NETP_ASSERT(r->cfg->L->in_event_loop());
+		const i64_t end_us = __dial_race_now_us();
+		if (so != nullptr) {
+			std::vector<NRP<socket_channel>>::iterator it = std::find(r->connecting.begin(), r->connecting.end(), so);
+			NETP_ASSERT(it != r->connecting.end());
+			r->connecting.erase(it);
+			--r->inflight;
+		}
+		if (r->cfg->dial_attempt_report != nullptr) {
+			r->cfg->dial_attempt_report({ addr, rt, start_us - r->begin_us, end_us - start_us });
+		}
+
+		if (r->winner != nullptr) {
+			if (so.get() == r->winner) {
+				r->ch_dialf->set(std::make_tuple(rt, (rt == netp::OK) ? so : nullptr));
+			}
+			return;
+		}
+
+		r->last_rt = rt;
+		if (r->next < r->addrs.size()) {
+			//do not wait for the stagger timer once the previous attempt failed
+			__dial_race_attempt(r);
+		} else if (r->inflight == 0) {
+			NETP_WARN("[socket]dial race failed after try count: %u, last dialrt: %d", r->addrs.size(), rt);
+			r->ch_dialf->set(std::make_tuple(rt, nullptr));
+		}
+	}
+
+	static void __dial_race_attempt(NRP<dial_race> const& r) {
+		NETP_ASSERT(r->cfg->L->in_event_loop());
+		if (r->winner != nullptr || r->next == r->addrs.size()) {
+			return;
+		}
+		NRP<address> const& addr = r->addrs[r->next++];
+		const i64_t start_us = __dial_race_now_us();
+
+		std::tuple<int, NRP<socket_channel>> tupc = create_socket_channel(r->cfg);
+		int rt = std::get<0>(tupc);
+		if (rt != netp::OK) {
+			__dial_race_attempt_done(r, nullptr, addr, start_us, rt);
+			return;
+		}
+		NRP<socket_channel> so = std::get<1>(tupc);
+		if (r->cfg->laddr != nullptr) {
+			rt = so->bind(r->cfg->laddr);
+			if (rt != netp::OK) {
+				so->ch_close();
+				__dial_race_attempt_done(r, nullptr, addr, start_us, rt);
+				return;
+			}
+		}
+
+		++r->inflight;
+		r->connecting.push_back(so);
+		NRP<promise<int>> so_dialp = netp::make_ref<promise<int>>();
+		so_dialp->if_done([r, so, addr, start_us](int const& rt) {
+			__dial_race_attempt_done(r, so, addr, start_us, rt);
+		});
+
+		if (r->next < r->addrs.size()) {
+			const netp::size_t n = r->next;
+			r->cfg->L->launch(netp::make_ref<netp::timer>(std::chrono::milliseconds(r->cfg->dial_race_delay_ms), [r, n](NRP<timer> const&) {
+				//skip it if a failure has started the next one already
+				if (r->next == n) {
+					__dial_race_attempt(r);
+				}
+			}), netp::make_ref<netp::promise<int>>());
+		}
+
+		so->do_dial(so_dialp, addr, [r](NRP<channel> const& ch) {
+			if (r->winner != nullptr) {
+				NETP_THROW2(netp::E_OP_ABORT, "dial race lost");
+			}
+			r->winner = static_cast<socket_channel*>(ch.get());
+			const std::vector<NRP<socket_channel>> losers = r->connecting;
+			for (std::vector<NRP<socket_channel>>::const_iterator it = losers.begin(); it != losers.end(); ++it) {
+				if ((*it).get() != r->winner) {
+					(*it)->ch_cancel_connect(netp::E_OP_ABORT);
+				}
+			}
+			r->initializer(ch);
+		});
+	}
+
+	static void __do_dial_race(NRP<dial_race> const& r) {
+		if (!r->cfg->L->in_event_loop()) {
+			r->cfg->L->schedule([r]() {
+				__do_dial_race(r);
+			});
+			return;
+		}
+		r->begin_us = __dial_race_now_us();
+		__dial_race_attempt(r);
+	}
+
 	void do_dial(NRP<channel_dial_promise> const& ch_dialf, netp::size_t idx, std::vector< NRP<address>, netp::allocator<NRP<address>>> const& addrs, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg) {
 		NETP_ASSERT( idx<addrs.size() );
 
+		if (idx == 0 && addrs.size() > 1 && cfg->dial_race_delay_ms > 0 && cfg->type == NETP_SOCK_STREAM) {
+			if (cfg->L == nullptr) {
+				cfg->L = netp::app::instance()->def_loop_group()->next();
+			}
+			NRP<dial_race> r = netp::make_ref<dial_race>();
+			r->ch_dialf = ch_dialf;
+			r->addrs = addrs;
+			r->initializer = initializer;
+			r->cfg = cfg;
+			r->next = 0;
+			r->inflight = 0;
+			r->last_rt = netp::OK;
+			r->winner = nullptr;
+			r->begin_us = 0;
+			__do_dial_race(r);
+			return;
+		}
+
 		NRP<channel_dial_promise> _dp = netp::make_ref<channel_dial_promise>();
 		_dp->if_done([idx, addrs, initializer, ch_dialf, cfg](std::tuple<int, NRP<channel>> const& tupc) {
 			int dialrt = std::get<0>(tupc);
@@ -184,6 +361,17 @@ namespace netp {
 			return;
 		}
 
+		if (_dcfg->family == NETP_AF_UNIX) {
+			NRP<address> raddr;
+			rt = __make_unix_address(info.host, raddr);
+			if (rt != netp::OK) {
+				ch_dialf->set(std::make_tuple(rt, nullptr));
+				return;
+			}
+			do_dial(ch_dialf, raddr, initializer, _dcfg);
+			return;
+		}
+
 		if (netp::is_dotipv4_decimal_notation(info.host.c_str())) {
 			do_dial(ch_dialf, netp::make_ref<address>(info.host.c_str(), info.port, _dcfg->family), initializer, _dcfg);
 			return;
@@ -247,28 +435,35 @@ namespace netp {
 		so->do_listen_on(listen_f, laddr, initializer, cfg, backlog);
 	}
 
-	NRP<channel_listen_promise> listen_on(const char* listenurl, size_t len, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg, int backlog ) {
-		NRP<channel_listen_promise> listenp = netp::make_ref<channel_listen_promise>();
-
+	static int __parse_listen_url(const char* listenurl, size_t len, NRP<socket_cfg> const& cfg, NRP<address>& laddr) {
 		socket_url_parse_info info;
 		int rt = parse_socket_url(listenurl, len, info);
-		if (rt != netp::OK) {
-			listenp->set(std::make_tuple(rt, nullptr));
-			return listenp;
-		}
+		NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 
 		std::tie(rt, cfg->family, cfg->type, cfg->proto) = inspect_address_info_from_dial_str(info.proto.c_str());
-		if (rt != netp::OK) {
-			listenp->set(std::make_tuple(rt, nullptr));
-			return listenp;
+		NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
+
+		if (cfg->family == NETP_AF_UNIX) {
+			return __make_unix_address(info.host, laddr);
 		}
 
 		if (!netp::is_dotipv4_decimal_notation(info.host.c_str())) {
-			listenp->set(std::make_tuple(netp::E_SOCKET_INVALID_ADDRESS, nullptr));
+			return netp::E_SOCKET_INVALID_ADDRESS;
+		}
+		laddr = netp::make_ref<address>(info.host.c_str(), info.port, cfg->family);
+		return netp::OK;
+	}
+
+	NRP<channel_listen_promise> listen_on(const char* listenurl, size_t len, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg, int backlog ) {
+		NRP<channel_listen_promise> listenp = netp::make_ref<channel_listen_promise>();
+
+		NRP<address> laddr;
+		int rt = __parse_listen_url(listenurl, len, cfg, laddr);
+		if (rt != netp::OK) {
+			listenp->set(std::make_tuple(rt, nullptr));
 			return listenp;
 		}
 
-		NRP<address> laddr=netp::make_ref<address>(info.host.c_str(), info.port, cfg->family);
 		if (cfg->L == nullptr) {
 			cfg->L = app::instance()->def_loop_group()->next();
 		}
@@ -284,4 +479,60 @@ namespace netp {
 		return listenp;
 	}
 
+	//listen one loop after another, the listeners of the first failure are closed
+	static void __do_listen_on_each_loop(NRP<channel_listen_group_promise> const& listenp, NRP<address> const& laddr, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg, int backlog, event_loop_vector_t const& loops, std::vector<NRP<channel>> const& listeners) {
+		const netp::size_t idx = listeners.size();
+		if (idx == loops.size()) {
+			listenp->set(std::make_tuple(netp::OK, listeners));
+			return;
+		}
+
+		NRP<socket_cfg> lcfg = cfg->clone();
+		lcfg->L = loops[idx];
+		NRP<channel_listen_promise> lp = netp::make_ref<channel_listen_promise>();
+		lp->if_done([listenp, laddr, initializer, cfg, backlog, loops, listeners](std::tuple<int, NRP<channel>> const& tupc) {
+			const int rt = std::get<0>(tupc);
+			if (rt != netp::OK) {
+				for (netp::size_t i = 0; i < listeners.size(); ++i) {
+					listeners[i]->ch_close();
+				}
+				listenp->set(std::make_tuple(rt, std::vector<NRP<channel>>()));
+				return;
+			}
+			std::vector<NRP<channel>> _listeners = listeners;
+			_listeners.push_back(std::get<1>(tupc));
+			__do_listen_on_each_loop(listenp, laddr, initializer, cfg, backlog, loops, _listeners);
+		});
+		lcfg->L->execute([lp, laddr, initializer, lcfg, backlog]() {
+			do_listen_on(lp, laddr, initializer, lcfg, backlog);
+		});
+	}
+
+	NRP<channel_listen_group_promise> listen_on_each_loop(const char* listenurl, size_t len, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg_, int backlog) {
+		NRP<channel_listen_group_promise> listenp = netp::make_ref<channel_listen_group_promise>();
+
+		//the options below are ours, the cfg of the caller is left as it is
+		NRP<socket_cfg> cfg = cfg_->clone();
+		NRP<address> laddr;
+		int rt = __parse_listen_url(listenurl, len, cfg, laddr);
+		if (rt != netp::OK) {
+			listenp->set(std::make_tuple(rt, std::vector<NRP<channel>>()));
+			return listenp;
+		}
+
+		event_loop_vector_t loops;
+#if defined(_NETP_GNU_LINUX) || defined(_NETP_ANDROID)
+		if (!laddr->is_unix() && laddr->port() != 0) {
+			loops = app::instance()->def_loop_group()->loops();
+			cfg->option |= (u16_t(socket_option::OPTION_REUSEPORT) | u16_t(socket_option::OPTION_ACCEPT_LOCAL));
+		}
+#endif
+		//the kernel does not balance SO_REUSEPORT here, one listener with the accepted channels spread by next()
+		if (loops.size() == 0) {
+			loops.push_back(cfg->L != nullptr ? cfg->L : app::instance()->def_loop_group()->next());
+		}
+		__do_listen_on_each_loop(listenp, laddr, initializer, cfg, backlog, loops, std::vector<NRP<channel>>());
+		return listenp;
+	}
+
 } //end of ns
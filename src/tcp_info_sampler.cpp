@@ -0,0 +1,151 @@
+#include <netp/tcp_info_sampler.hpp>
+
+namespace netp {
+
+	tcp_info_sampler::tcp_info_sampler(NRP<event_loop> const& L_, timer_duration_t const& interval) :
+		L(L_),
+		m_interval(interval),
+		m_running(false),
+		m_tm_pending(false)
+	{
+		NETP_ASSERT(L != nullptr);
+		NETP_ASSERT(m_interval.count() > 0);
+	}
+
+	void tcp_info_sampler::_tmcb_sample(NRP<timer> const& t) {
+		NETP_ASSERT(L->in_event_loop());
+		m_tm_pending = false;
+		if (!m_running) {
+			return;
+		}
+
+		for (sampled_channel_vector_t::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+			(*it)->rt = (*it)->ch->get_tcp_info((*it)->info);
+		}
+
+		{
+			lock_guard<spin_mutex> lg(m_mtx);
+			sampled_channel_vector_t::iterator it = m_channels.begin();
+			while (it != m_channels.end()) {
+				sampled_channel* sc = (*it).get();
+				if (sc->rt != netp::OK) {
+					it = m_channels.erase(it);
+					continue;
+				}
+				const u32_t retrans_delta = sc->info.total_retrans - sc->total_retrans;
+				sc->total_retrans = sc->info.total_retrans;
+				sc->st.record(sc->info, retrans_delta);
+				m_aggregate.record(sc->info, retrans_delta);
+				++it;
+			}
+		}
+
+		m_tm_pending = true;
+		L->launch(t, netp::make_ref<netp::promise<int>>());
+	}
+
+	void tcp_info_sampler::_do_start() {
+		NETP_ASSERT(L->in_event_loop());
+		m_running = true;
+		if (m_tm_pending) {
+			return;
+		}
+		m_tm_pending = true;
+		L->launch(netp::make_ref<netp::timer>(m_interval, &tcp_info_sampler::_tmcb_sample, NRP<tcp_info_sampler>(this), std::placeholders::_1), netp::make_ref<netp::promise<int>>());
+	}
+
+	void tcp_info_sampler::_do_stop() {
+		NETP_ASSERT(L->in_event_loop());
+		m_running = false;
+	}
+
+	void tcp_info_sampler::_do_watch(NRP<socket_channel> const& ch) {
+		NETP_ASSERT(L->in_event_loop());
+		for (sampled_channel_vector_t::const_iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+			if ((*it)->ch == ch) {
+				return;
+			}
+		}
+		NRP<sampled_channel> sc = netp::make_ref<sampled_channel>();
+		sc->ch = ch;
+		socket_tcp_info info;
+		sc->total_retrans = (ch->get_tcp_info(info) == netp::OK) ? info.total_retrans : 0;
+
+		lock_guard<spin_mutex> lg(m_mtx);
+		m_channels.push_back(sc);
+	}
+
+	void tcp_info_sampler::_do_unwatch(NRP<socket_channel> const& ch) {
+		NETP_ASSERT(L->in_event_loop());
+		lock_guard<spin_mutex> lg(m_mtx);
+		for (sampled_channel_vector_t::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+			if ((*it)->ch == ch) {
+				m_channels.erase(it);
+				return;
+			}
+		}
+	}
+
+	void tcp_info_sampler::start() {
+		if (L->in_event_loop()) {
+			_do_start();
+			return;
+		}
+		L->execute([s = NRP<tcp_info_sampler>(this)]() {
+			s->_do_start();
+		});
+	}
+
+	void tcp_info_sampler::stop() {
+		if (L->in_event_loop()) {
+			_do_stop();
+			return;
+		}
+		L->execute([s = NRP<tcp_info_sampler>(this)]() {
+			s->_do_stop();
+		});
+	}
+
+	int tcp_info_sampler::watch(NRP<socket_channel> const& ch) {
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, ch == nullptr || ch->L != L || !ch->is_tcp());
+		if (L->in_event_loop()) {
+			_do_watch(ch);
+			return netp::OK;
+		}
+		L->execute([s = NRP<tcp_info_sampler>(this), ch]() {
+			s->_do_watch(ch);
+		});
+		return netp::OK;
+	}
+
+	void tcp_info_sampler::unwatch(NRP<socket_channel> const& ch) {
+		if (L->in_event_loop()) {
+			_do_unwatch(ch);
+			return;
+		}
+		L->execute([s = NRP<tcp_info_sampler>(this), ch]() {
+			s->_do_unwatch(ch);
+		});
+	}
+
+	bool tcp_info_sampler::channel_snapshot(NRP<socket_channel> const& ch, tcp_info_stat& o) const {
+		lock_guard<spin_mutex> lg(m_mtx);
+		for (sampled_channel_vector_t::const_iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+			if ((*it)->ch == ch) {
+				o = (*it)->st;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void tcp_info_sampler::aggregate_snapshot(tcp_info_histograms& o) const {
+		lock_guard<spin_mutex> lg(m_mtx);
+		o = m_aggregate;
+	}
+
+	void tcp_info_sampler::reset_aggregate() {
+		lock_guard<spin_mutex> lg(m_mtx);
+		m_aggregate.reset();
+	}
+}
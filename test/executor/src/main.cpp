@@ -0,0 +1,126 @@
+#include <netp.hpp>
+
+//scaling benchmark of netp::executor, the same jobs run on 1..N workers
+//flat: the main thread executes all the tasks, fork-join: one task splits a range into halves till the leaf size
+//usage: executor [leaf tasks] [spin per task] [worker count]..., default: 100000 2000 1 2 4 ... hardware_concurrency
+
+static std::atomic<netp::u64_t> __sink(0);
+
+inline void burn(netp::u32_t spin) {
+	netp::u32_t x = spin | 1;
+	for (netp::u32_t i = 0; i < spin; ++i) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+	}
+	__sink.fetch_add(x, std::memory_order_relaxed);
+}
+
+//the range a fork-join task runs by itself
+#define FORK_JOIN_LEAF 4
+
+void split(netp::executor* E, netp::u32_t spin, long lo, long hi) {
+	if ((hi - lo) <= FORK_JOIN_LEAF) {
+		for (long i = lo; i < hi; ++i) {
+			burn(spin);
+		}
+		return;
+	}
+	const long mid = lo + ((hi - lo) >> 1);
+	E->execute([E, spin, lo, mid]() { split(E, spin, lo, mid); });
+	E->execute([E, spin, mid, hi]() { split(E, spin, mid, hi); });
+}
+
+//stop() returns once the queued tasks and the ones they execute are done, a round ends by it
+//return tasks per second
+double run_flat(netp::u32_t workers, long tasks, netp::u32_t spin) {
+	NRP<netp::executor> E = netp::make_ref<netp::executor>(workers);
+	int rt = E->start();
+	NETP_ASSERT(rt == netp::OK);
+	netp::benchmark bmarker("flat", netp::bf_no_end_output | netp::bf_no_mark_output);
+	for (long i = 0; i < tasks; ++i) {
+		E->execute([spin]() { burn(spin); });
+	}
+	E->stop();
+	const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(bmarker.elapsed()).count();
+	return (tasks * 1000000000.0) / ns;
+}
+
+double run_fork_join(netp::u32_t workers, long tasks, netp::u32_t spin) {
+	NRP<netp::executor> E = netp::make_ref<netp::executor>(workers);
+	int rt = E->start();
+	NETP_ASSERT(rt == netp::OK);
+	netp::executor* e = E.get();
+	netp::benchmark bmarker("fork-join", netp::bf_no_end_output | netp::bf_no_mark_output);
+	E->execute([e, spin, tasks]() { split(e, spin, 0, tasks); });
+	E->stop();
+	const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(bmarker.elapsed()).count();
+	return (tasks * 1000000000.0) / ns;
+}
+
+//a cpu bound job off the loop, the result is handled back on the loop that asked for it
+void loop_round_trip(NRP<netp::event_loop> const& L) {
+	NRP<netp::executor> E = netp::make_ref<netp::executor>(2);
+	int rt = E->start();
+	NETP_ASSERT(rt == netp::OK);
+
+	NRP<netp::promise<bool>> on_loop = netp::make_ref<netp::promise<bool>>();
+	L->execute([E, L, on_loop]() {
+		E->execute_on_loop(L, []() {
+			long sum = 0;
+			for (long i = 1; i <= 1000; ++i) { sum += i; }
+			return sum;
+		}, [L, on_loop](long sum) {
+			on_loop->set(L->in_event_loop() && sum == 500500);
+		}, netp::EP_HIGH);
+	});
+	NETP_INFO("[executor]execute_on_loop resumed on the loop: %s", on_loop->get() ? "yes" : "no");
+
+	NRP<netp::promise<std::tuple<int, long>>> p = E->submit([]() { return 42L; });
+	NETP_INFO("[executor]submit: %d, %ld", std::get<0>(p->get()), std::get<1>(p->get()));
+
+	//the worker survives a throwing job, the promise carries the error
+	NRP<netp::promise<std::tuple<int, long>>> pe = E->submit([]() -> long { NETP_THROW("job failed"); });
+	NRP<netp::promise<bool>> pt = netp::make_ref<netp::promise<bool>>();
+	E->execute([]() { throw std::runtime_error("job failed"); });
+	E->execute([pt]() { pt->set(true); });
+	NETP_INFO("[executor]throwing submit: %d, next job: %s", std::get<0>(pe->get()), pt->get() ? "done" : "lost");
+	E->stop();
+
+	NRP<netp::promise<std::tuple<int, long>>> ps = E->submit([]() { return 42L; });
+	NETP_INFO("[executor]submit after stop: %d, execute after stop: %d", std::get<0>(ps->get()), E->execute([]() {}));
+}
+
+int main(int argc, char** argv) {
+	netp::app::instance()->init(argc, argv);
+	netp::app::instance()->start_loop();
+
+	long tasks = (argc > 1) ? std::atol(argv[1]) : 100000;
+	netp::u32_t spin = (argc > 2) ? netp::u32_t(std::atol(argv[2])) : 2000;
+	std::vector<netp::u32_t> rounds;
+	for (int i = 3; i < argc; ++i) {
+		rounds.push_back(netp::u32_t(std::atoi(argv[i])));
+	}
+	if (rounds.empty()) {
+		const netp::u32_t hc = std::max(1u, std::thread::hardware_concurrency());
+		for (netp::u32_t n = 1; n < hc; n <<= 1) {
+			rounds.push_back(n);
+		}
+		rounds.push_back(hc);
+	}
+
+	double flat_1 = 0, fj_1 = 0;
+	for (std::size_t i = 0; i < rounds.size(); ++i) {
+		const double flat = run_flat(rounds[i], tasks, spin);
+		const double fj = run_fork_join(rounds[i], tasks, spin);
+		if (i == 0) {
+			flat_1 = flat;
+			fj_1 = fj;
+		}
+		NETP_INFO("[executor]workers: %u, flat: %.0f task/s (x%.2f), fork-join: %.0f task/s (x%.2f)",
+			rounds[i], flat, flat / flat_1, fj, fj / fj_1);
+	}
+
+	loop_round_trip(netp::app::instance()->def_loop_group()->next());
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include <netp.hpp>
+
+//ping-pong benchmark of the poller backend, N connections each keep one packet in flight to an echo server
+//the poller of the default loop group is picked by --netp-poller, run it once with epoll and once with io_uring to compare
+//usage: poller [connections] [round trips per connection] [packet size] [--netp-poller=epoll|io_uring], default: 64 20000 64
+
+class echo :
+	public netp::channel_handler_abstract
+{
+public:
+	echo() :
+		channel_handler_abstract(netp::CH_INBOUND_READ)
+	{}
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		ctx->write(income);
+	}
+};
+
+//the pingers left, the last one done ends the wait of main
+static std::atomic<long> g_channels(0);
+
+class pinger :
+	public netp::channel_handler_abstract
+{
+	long m_left;
+	netp::u32_t m_size;
+	netp::u32_t m_got;
+public:
+	pinger(long rounds, netp::u32_t size) :
+		channel_handler_abstract(netp::CH_ACTIVITY_CONNECTED | netp::CH_INBOUND_READ),
+		m_left(rounds),
+		m_size(size),
+		m_got(0)
+	{}
+	void ping(NRP<netp::channel_handler_context> const& ctx) {
+		NRP<netp::packet> p = netp::make_ref<netp::packet>(m_size);
+		p->incre_write_idx(m_size);
+		ctx->write(p);
+	}
+	void connected(NRP<netp::channel_handler_context> const& ctx) override {
+		ping(ctx);
+	}
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		m_got += income->len();
+		if (m_got < m_size) {
+			return;
+		}
+		m_got = 0;
+		if (--m_left > 0) {
+			ping(ctx);
+			return;
+		}
+		if (netp::atomic_decre(&g_channels, std::memory_order_acq_rel) == 1) {
+			::raise(SIGTERM);
+		}
+	}
+};
+
+int main(int argc, char** argv) {
+	netp::app::instance()->init(argc, argv);
+	netp::app::instance()->start_loop();
+
+	//getopt moves the options of the app ahead or behind, pick the positional ones
+	std::vector<long> args;
+	for (int i = 1; i < argc; ++i) {
+		if (argv[i][0] != '-') {
+			args.push_back(std::atol(argv[i]));
+		}
+	}
+	const long connections = args.size() > 0 ? args[0] : 64;
+	const long rounds = args.size() > 1 ? args[1] : 20000;
+	const netp::u32_t size = args.size() > 2 ? netp::u32_t(args[2]) : 64;
+
+	const std::string url = "tcp://127.0.0.1:13109";
+	NRP<netp::channel_listen_promise> lp = netp::listen_on(url, [](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(netp::make_ref<echo>());
+	});
+	if (std::get<0>(lp->get()) != netp::OK) {
+		NETP_ERR("[poller]listen on %s failed: %d", url.c_str(), std::get<0>(lp->get()));
+		return std::get<0>(lp->get());
+	}
+
+	g_channels = connections;
+	std::vector<NRP<netp::channel>> chs;
+	netp::benchmark bmarker("poller", netp::bf_no_end_output | netp::bf_no_mark_output);
+	for (long i = 0; i < connections; ++i) {
+		NRP<netp::channel_dial_promise> dp = netp::dial(url, [rounds, size](NRP<netp::channel> const& ch) {
+			ch->pipeline()->add_last(netp::make_ref<pinger>(rounds, size));
+		});
+		if (std::get<0>(dp->get()) != netp::OK) {
+			NETP_ERR("[poller]dial failed: %d", std::get<0>(dp->get()));
+			return std::get<0>(dp->get());
+		}
+		chs.push_back(std::get<1>(dp->get()));
+	}
+	netp::app::instance()->wait();
+	const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(bmarker.elapsed()).count();
+
+	NETP_INFO("[poller]poller: %u, connections: %ld, round trips: %ld, size: %u, %.0f rtt/s, %.2f us/rtt",
+		netp::app::instance()->def_loop_group()->next()->poller_type(), connections, connections * rounds, size,
+		(connections * rounds * 1000000000.0) / ns, (ns / 1000.0) / (connections * rounds));
+
+	for (std::size_t i = 0; i < chs.size(); ++i) {
+		chs[i]->ch_close();
+	}
+	std::get<1>(lp->get())->ch_close();
+	return 0;
+}
@@ -0,0 +1,175 @@
+#include <netp.hpp>
+
+//contention benchmark of event_loop::schedule, N producer threads post to one loop
+//then the same rounds on the task queue alone, the mpsc_queue against the old spin_mutex+vector swap
+//usage: schedule [tasks per producer] [producer count]..., default: 200000 1 2 4 8 16
+
+void run_round(NRP<netp::event_loop> const& L, int producers, long per_producer) {
+	const long total = long(producers) * per_producer;
+	long done = 0;
+	NRP<netp::promise<int>> donep = netp::make_ref<netp::promise<int>>();
+	std::atomic<int> ready(0);
+	std::atomic<bool> go(false);
+
+	//netp::thread sets up the tls allocator that a schedule() spilled to the overflow of the task queue allocates from
+	std::vector<NRP<netp::thread>> ths;
+	for (int i = 0; i < producers; ++i) {
+		NRP<netp::thread> th = netp::make_ref<netp::thread>();
+		ths.push_back(th);
+		th->start([&ready, &go, &done, &donep, L, total, per_producer]() {
+			++ready;
+			while (!go.load(std::memory_order_acquire)) {}
+			long* d = &done;
+			netp::promise<int>* p = donep.get();
+			for (long j = 0; j < per_producer; ++j) {
+				//the loop is the only writer of done
+				L->schedule([d, p, total]() {
+					if (++(*d) == total) {
+						p->set(netp::OK);
+					}
+				});
+			}
+		});
+	}
+	while (ready.load() != producers) {}
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	go.store(true, std::memory_order_release);
+	for (std::size_t i = 0; i < ths.size(); ++i) {
+		ths[i]->join();
+	}
+	std::chrono::steady_clock::time_point pushed = std::chrono::steady_clock::now();
+	donep->wait();
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	const long long push_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(pushed - begin).count();
+	const long long total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+	//push: wall time of a producer per schedule call, run: tasks run by the loop per second till the last one
+	NETP_INFO("[schedule]producers: %d, tasks: %ld, push: %lld ns/call, run: %.2f Mtask/s", producers, total,
+		push_ns / per_producer, (total * 1000.0) / total_ns);
+}
+
+//A/B of the task queue alone, no poller and no wakeup: netp::mpsc_queue against the spin_mutex guarded vector swap it replaced
+//the consumer is the calling thread, it drains till all the tasks have run
+struct spin_vector_q {
+	typedef std::vector<netp::task, netp::allocator<netp::task>> task_vector_t;
+	netp::spin_mutex mtx;
+	task_vector_t standby;
+	task_vector_t q;
+
+	inline void push(netp::task&& t) {
+		netp::lock_guard<netp::spin_mutex> lg(mtx);
+		standby.emplace_back(std::move(t));
+	}
+
+	template <class _Fn>
+	std::size_t consume(_Fn&& fn) {
+		{
+			netp::lock_guard<netp::spin_mutex> lg(mtx);
+			q.swap(standby);
+		}
+		const std::size_t n = q.size();
+		for (std::size_t i = 0; i < n; ++i) {
+			fn(q[i]);
+		}
+		q.clear();
+		return n;
+	}
+};
+
+//window: the tasks a producer keeps in flight, 0 for no limit
+template <class _QueueT>
+double run_queue_round(int producers, long per_producer, long window) {
+	_QueueT q;
+	long done = 0;
+	const long total = long(producers) * per_producer;
+	std::vector<std::atomic<long>> ran(producers); //the consumer is the only writer
+	std::atomic<int> ready(0);
+	std::atomic<bool> go(false);
+
+	std::vector<NRP<netp::thread>> ths;
+	for (int i = 0; i < producers; ++i) {
+		ran[i].store(0, std::memory_order_relaxed);
+		NRP<netp::thread> th = netp::make_ref<netp::thread>();
+		ths.push_back(th);
+		th->start([&q, &ready, &go, &done, &ran, i, per_producer, window]() {
+			++ready;
+			while (!go.load(std::memory_order_acquire)) {}
+			long* d = &done;
+			std::atomic<long>* r = &ran[i];
+			for (long j = 0; j < per_producer; ++j) {
+				while (window != 0 && (j - r->load(std::memory_order_acquire)) >= window) {
+					netp::this_thread::no_interrupt_yield();
+				}
+				q.push([d, r]() {
+					++(*d);
+					r->store(r->load(std::memory_order_relaxed) + 1, std::memory_order_release);
+				});
+			}
+		});
+	}
+	while (ready.load() != producers) {}
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	go.store(true, std::memory_order_release);
+	while (done != total) {
+		if (q.consume([](netp::task& t) { t(); }) == 0) {
+			netp::this_thread::no_interrupt_yield();
+		}
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < ths.size(); ++i) {
+		ths[i]->join();
+	}
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()) / total;
+}
+
+//flood: the producers outrun the consumer, the ring of the mpsc_queue fills up and the rest goes by its overflow
+//window 32: at most 32 tasks of a producer in flight, the ring is never full
+void run_queue_ab(int producers, long per_producer) {
+	const double mpsc = run_queue_round<netp::mpsc_queue<netp::task>>(producers, per_producer, 0);
+	const double vec = run_queue_round<spin_vector_q>(producers, per_producer, 0);
+	const double mpsc_w = run_queue_round<netp::mpsc_queue<netp::task>>(producers, per_producer, 32);
+	const double vec_w = run_queue_round<spin_vector_q>(producers, per_producer, 32);
+	NETP_INFO("[schedule]queue A/B, producers: %d, flood, mpsc_queue: %.1f ns/task, spin_mutex+vector: %.1f ns/task; window 32, mpsc_queue: %.1f ns/task, spin_mutex+vector: %.1f ns/task",
+		producers, mpsc, vec, mpsc_w, vec_w);
+}
+
+void dump_latency(const char* name, netp::histogram const& h) {
+	NETP_INFO("[schedule]%s: count: %llu, mean: %.1f, p50: %llu, p99: %llu, max: %llu", name, (unsigned long long)h.count(), h.mean(),
+		(unsigned long long)h.percentile(50), (unsigned long long)h.percentile(99), (unsigned long long)h.max());
+}
+
+int main(int argc, char** argv) {
+	netp::app::instance()->init(argc, argv);
+	netp::app::instance()->start_loop();
+
+	long per_producer = (argc > 1) ? std::atol(argv[1]) : 200000;
+	std::vector<int> rounds;
+	for (int i = 2; i < argc; ++i) {
+		rounds.push_back(std::atoi(argv[i]));
+	}
+	if (rounds.empty()) {
+		rounds = { 1, 2, 4, 8, 16 };
+	}
+
+	NRP<netp::event_loop> L = netp::app::instance()->def_loop_group()->next();
+	for (std::size_t i = 0; i < rounds.size(); ++i) {
+		run_round(L, rounds[i], per_producer);
+	}
+
+	for (std::size_t i = 0; i < rounds.size(); ++i) {
+		run_queue_ab(rounds[i], per_producer);
+	}
+
+	netp::event_loop_latency_stat ls;
+	netp::app::instance()->def_loop_group()->latency_snapshot(ls);
+	NETP_INFO("[schedule]wakeups: %llu", (unsigned long long)ls.wakeups);
+	dump_latency("task_ns", ls.task_ns);
+	dump_latency("task_depth", ls.task_depth);
+	dump_latency("timer_ns", ls.timer_ns);
+	dump_latency("poll_ns", ls.poll_ns);
+	dump_latency("io_ns", ls.io_ns);
+	dump_latency("ready_events", ls.ready_events);
+	return 0;
+}
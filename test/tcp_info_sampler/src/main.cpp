@@ -0,0 +1,136 @@
+#include <netp.hpp>
+
+//histogram and value_stat, then a tcp_info_sampler on a loopback tcp connection: record, snapshot, unwatch and the drop of a closed channel
+//usage: tcp_info_sampler [interval ms], default: 5
+
+class echo :
+	public netp::channel_handler_abstract
+{
+public:
+	echo() :
+		channel_handler_abstract(netp::CH_INBOUND_READ)
+	{}
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		ctx->write(income);
+	}
+};
+
+static int __failed = 0;
+#define CHECK(cond) do { if (!(cond)) { ++__failed; NETP_ERR("[tcp_info_sampler]check failed: %s, line: %d", #cond, __LINE__); } } while (0)
+
+void test_histogram() {
+	netp::histogram h;
+	for (netp::u64_t v = 1; v <= 1000; ++v) {
+		h.record(v);
+	}
+	CHECK(h.count() == 1000);
+	CHECK(h.min() == 1);
+	CHECK(h.max() == 1000);
+	//a bucket is at most 12.5% wide
+	const netp::u64_t p50 = h.percentile(50);
+	CHECK(p50 >= 500 && p50 <= 563);
+	const netp::u64_t p99 = h.percentile(99);
+	CHECK(p99 >= 990 && p99 <= 1000);
+
+	netp::histogram h2;
+	h2.record(5000);
+	h.merge(h2);
+	CHECK(h.count() == 1001);
+	CHECK(h.max() == 5000);
+
+	netp::value_stat vs;
+	CHECK(vs.count == 0 && vs.mean() == 0.0);
+	vs.record(7);
+	vs.record(3);
+	vs.record(11);
+	CHECK(vs.count == 3 && vs.min == 3 && vs.max == 11 && vs.last == 11 && vs.sum == 21);
+}
+
+//run on L and wait, the sampler changes m_channels on L only
+void sync_loop(NRP<netp::event_loop> const& L) {
+	NRP<netp::promise<int>> p = netp::make_ref<netp::promise<int>>();
+	L->execute([p]() { p->set(netp::OK); });
+	p->wait();
+}
+
+void test_sampler(long interval_ms) {
+	const std::string url = "tcp://127.0.0.1:13119";
+	NRP<netp::channel_listen_promise> lp = netp::listen_on(url, [](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(netp::make_ref<echo>());
+	});
+	if (std::get<0>(lp->get()) != netp::OK) {
+		NETP_ERR("[tcp_info_sampler]listen on %s failed: %d", url.c_str(), std::get<0>(lp->get()));
+		++__failed;
+		return;
+	}
+	NRP<netp::channel_dial_promise> dp = netp::dial(url, [](NRP<netp::channel> const&) {});
+	if (std::get<0>(dp->get()) != netp::OK) {
+		NETP_ERR("[tcp_info_sampler]dial %s failed: %d", url.c_str(), std::get<0>(dp->get()));
+		++__failed;
+		std::get<1>(lp->get())->ch_close();
+		return;
+	}
+	NRP<netp::channel> ch = std::get<1>(dp->get());
+	NRP<netp::socket_channel> so(static_cast<netp::socket_channel*>(ch.get()));
+
+#ifdef NETP_ENABLE_SOCKET_TCP_INFO
+	NRP<netp::tcp_info_sampler> sampler = netp::make_ref<netp::tcp_info_sampler>(so->L, std::chrono::milliseconds(interval_ms));
+	CHECK(sampler->watch(so) == netp::OK);
+	sampler->start();
+
+	for (int i = 0; i < 20; ++i) {
+		ch->ch_write(netp::make_ref<netp::packet>("ping", 4));
+		netp::this_thread::usleep(interval_ms * 1000);
+	}
+	netp::this_thread::usleep(interval_ms * 3000);
+
+	netp::tcp_info_stat st;
+	CHECK(sampler->channel_snapshot(so, st) == true);
+	CHECK(st.rtt_us.count > 0);
+	CHECK(st.snd_cwnd.count == st.rtt_us.count && st.snd_cwnd.min > 0);
+	netp::tcp_info_histograms agg;
+	sampler->aggregate_snapshot(agg);
+	CHECK(agg.rtt_us.count() == st.rtt_us.count);
+	NETP_INFO("[tcp_info_sampler]samples: %llu, rtt_us min: %llu, mean: %.1f, max: %llu, aggregate p50: %llu",
+		(unsigned long long)st.rtt_us.count, (unsigned long long)st.rtt_us.min, st.rtt_us.mean(), (unsigned long long)st.rtt_us.max,
+		(unsigned long long)agg.rtt_us.percentile(50));
+
+	sampler->reset_aggregate();
+	sampler->aggregate_snapshot(agg);
+	CHECK(agg.rtt_us.count() == 0);
+
+	sampler->unwatch(so);
+	sync_loop(so->L);
+	CHECK(sampler->channel_snapshot(so, st) == false);
+
+	//a closed channel is dropped at the next tick
+	CHECK(sampler->watch(so) == netp::OK);
+	sync_loop(so->L);
+	CHECK(sampler->channel_snapshot(so, st) == true);
+	ch->ch_close()->wait();
+	netp::this_thread::usleep(interval_ms * 3000);
+	sync_loop(so->L);
+	CHECK(sampler->channel_snapshot(so, st) == false);
+	CHECK(sampler->watch(NRP<netp::socket_channel>(nullptr)) == netp::E_INVALID_OPERATION);
+
+	sampler->stop();
+#else
+	NETP_INFO("[tcp_info_sampler]no TCP_INFO on this platform, sampler skipped");
+	ch->ch_close()->wait();
+#endif
+	std::get<1>(lp->get())->ch_close()->wait();
+}
+
+int main(int argc, char** argv) {
+	netp::app::instance()->init(argc, argv);
+	netp::app::instance()->start_loop();
+
+	const long interval_ms = (argc > 1) ? std::atol(argv[1]) : 5;
+	test_histogram();
+	test_sampler(interval_ms);
+	NETP_INFO("[tcp_info_sampler]%s", __failed == 0 ? "PASSED" : "FAILED");
+
+	::raise(SIGTERM);
+	netp::app::instance()->wait();
+	return __failed;
+}
@@ -0,0 +1,114 @@
+#include <netp.hpp>
+
+//round trip over a unix stream socket: listen, dial, write, echo, read
+//the listen path is left stale on purpose first, bind is expected to take it over, a live path is expected to be refused
+//usage: unix_socket [path], default: /tmp/netp_unix_socket_test.sock
+
+class echo :
+	public netp::channel_handler_abstract
+{
+public:
+	echo() :
+		channel_handler_abstract(netp::CH_INBOUND_READ)
+	{}
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		ctx->write(income);
+	}
+};
+
+class ping :
+	public netp::channel_handler_abstract
+{
+	std::string m_got;
+	std::string m_expect;
+	NRP<netp::promise<bool>> m_donep;
+public:
+	ping(std::string const& expect, NRP<netp::promise<bool>> const& donep) :
+		channel_handler_abstract(netp::CH_INBOUND_READ),
+		m_expect(expect),
+		m_donep(donep)
+	{}
+	void read(NRP<netp::channel_handler_context> const&, NRP<netp::packet> const& income) override {
+		m_got.append((char*)income->head(), income->len());
+		if (m_got.length() >= m_expect.length()) {
+			m_donep->set(m_got == m_expect);
+		}
+	}
+};
+
+//a bound socket closed without unlink, what a crashed server leaves behind
+static bool make_stale_path(std::string const& path) {
+	::unlink(path.c_str());
+	const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1) {
+		return false;
+	}
+	struct sockaddr_un un;
+	std::memset(&un, 0, sizeof(un));
+	un.sun_family = AF_UNIX;
+	std::strncpy(un.sun_path, path.c_str(), sizeof(un.sun_path) - 1);
+	const int rt = ::bind(fd, (struct sockaddr*)&un, sizeof(un));
+	::close(fd);
+	return rt == 0;
+}
+
+int main(int argc, char** argv) {
+	netp::app::instance()->init(argc, argv);
+	netp::app::instance()->start_loop();
+
+	const std::string path = (argc > 1) ? std::string(argv[1]) : std::string("/tmp/netp_unix_socket_test.sock");
+	const std::string url = "unix://" + path;
+	int failed = 0;
+
+	if (!make_stale_path(path)) {
+		NETP_ERR("[unix_socket]make stale path %s failed: %d", path.c_str(), netp_socket_get_last_errno());
+		return -1;
+	}
+
+	NRP<netp::channel_listen_promise> lp = netp::listen_on(url, [](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(netp::make_ref<echo>());
+	});
+	const int lrt = std::get<0>(lp->get());
+	NETP_INFO("[unix_socket]listen on the stale path: %d", lrt);
+	if (lrt != netp::OK) {
+		NETP_ERR("[unix_socket]FAILED, listen on %s: %d", url.c_str(), lrt);
+		return lrt;
+	}
+
+	NRP<netp::channel_listen_promise> lp2 = netp::listen_on(url, [](NRP<netp::channel> const&) {});
+	const int lrt2 = std::get<0>(lp2->get());
+	NETP_INFO("[unix_socket]listen on the live path: %d", lrt2);
+	if (lrt2 != netp::E_EADDRINUSE) {
+		++failed;
+		if (lrt2 == netp::OK) {
+			std::get<1>(lp2->get())->ch_close();
+		}
+	}
+
+	const std::string message = "hello over unix socket";
+	NRP<netp::promise<bool>> donep = netp::make_ref<netp::promise<bool>>();
+	NRP<netp::channel_dial_promise> dp = netp::dial(url, [message, donep](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(netp::make_ref<ping>(message, donep));
+	});
+	const int drt = std::get<0>(dp->get());
+	NETP_INFO("[unix_socket]dial: %d", drt);
+	if (drt == netp::OK) {
+		NRP<netp::channel> ch = std::get<1>(dp->get());
+		ch->ch_write(netp::make_ref<netp::packet>(message.c_str(), netp::u32_t(message.length())));
+		const bool echoed = donep->get();
+		NETP_INFO("[unix_socket]echo: %s", echoed ? "match" : "mismatch");
+		if (!echoed) {
+			++failed;
+		}
+		ch->ch_close();
+	} else {
+		++failed;
+	}
+
+	std::get<1>(lp->get())->ch_close()->wait();
+	NETP_INFO("[unix_socket]%s", failed == 0 ? "PASSED" : "FAILED");
+
+	::raise(SIGTERM);
+	netp::app::instance()->wait();
+	return failed;
+}